@@ -0,0 +1,550 @@
+#include "bitboard.h"
+#include "eval.h"
+#include "movegen.h"
+#include "nnue.h"
+#include "position.h"
+#include "pst.h"
+#include "search.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+const int benchsamples = 4096;
+const int benchrounds = 500;
+
+struct Sample
+{
+    int sq;
+    Bitboard occupied;
+};
+
+static Bitboard nextRandom(Bitboard &seed)
+{
+    seed ^= seed >> 12;
+    seed ^= seed << 25;
+    seed ^= seed >> 27;
+    return seed * 2685821657736338717ULL;
+}
+
+static vector<Sample> makeSamples()
+{
+    vector<Sample> samples(benchsamples);
+    Bitboard seed = 0x2545F4914F6CDD1DULL;
+    for (Sample &s : samples)
+    {
+        Bitboard r1 = nextRandom(seed);
+        Bitboard r2 = nextRandom(seed);
+        s.sq = (int)(r1 & 63);
+        s.occupied = (r1 & r2) & ~squareBit(s.sq);
+    }
+    return samples;
+}
+
+template <typename Lookup>
+static void timeLookups(const char *name, const vector<Sample> &samples, Lookup lookup)
+{
+    Bitboard checksum = 0;
+    auto start = chrono::steady_clock::now();
+    for (int round = 0; round < benchrounds; round++)
+    {
+        for (const Sample &s : samples)
+        {
+            checksum += lookup(s.sq, s.occupied);
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    double lookups = (double)benchrounds * samples.size();
+    printf("%-22s %8.2f ns/lookup  %8.1f M/s  checksum %016llx\n", name,
+           seconds * 1e9 / lookups, lookups / seconds / 1e6, checksum);
+}
+
+static void benchSliders(const vector<Sample> &samples)
+{
+    printf("Slider attacks (rook + bishop per lookup)\n");
+    timeLookups("ray walk", samples, [](int sq, Bitboard occ)
+                { return rayRookAttacks(sq, occ) ^ rayBishopAttacks(sq, occ); });
+
+    initAttacks(false);
+    timeLookups("magic multiply", samples, [](int sq, Bitboard occ)
+                { return rookAttacks(sq, occ) ^ bishopAttacks(sq, occ); });
+
+    if (cpuHasPext())
+    {
+        initAttacks(true);
+        timeLookups("pext", samples, [](int sq, Bitboard occ)
+                    { return rookAttacks(sq, occ) ^ bishopAttacks(sq, occ); });
+    }
+    else
+    {
+        printf("pext                   not supported by this CPU\n");
+    }
+}
+
+static const char *middlegames[] = {
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP1B1PPP/R2QKB1R w KQ - 3 8",
+    "2rq1rk1/pb1nbppp/1p2pn2/2ppN3/3P1B2/2PBP3/PP1N1PPP/R2QK2R w KQ - 0 11",
+    "r1b2rk1/2q1bppp/p2p1n2/np2p3/3PP3/5N1P/PPBN1PP1/R1BQR1K1 b - - 0 13",
+    "6k1/5p2/6p1/8/7p/8/6PP/6K1 b - - 0 1",
+};
+
+// The old isKingInCheck direction: ask every enemy piece whether it reaches the king.
+static bool forwardInCheck(const Position &pos, int color)
+{
+    int king = pos.kingSquare(color);
+    int them = opponent(color);
+    for (int t = 0; t < piecetypes; t++)
+    {
+        Bitboard attackers = pos.pieces(them, t);
+        while (attackers)
+        {
+            if (pieceAttacks(them, t, popLsb(attackers), pos.occupied()) & squareBit(king))
+                return true;
+        }
+    }
+    return false;
+}
+
+static bool reverseInCheck(const Position &pos, int color)
+{
+    return pos.attackersTo(pos.kingSquare(color), pos.occupied()) & pos.pieces(opponent(color));
+}
+
+template <typename Detect>
+static void timeCheckDetection(const char *name, const vector<Position> &positions, Detect detect)
+{
+    const int rounds = 200000;
+    long long hits = 0;
+    auto start = chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++)
+    {
+        for (const Position &pos : positions)
+        {
+            hits += detect(pos, colorwhite);
+            hits += detect(pos, colorblack);
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    double tests = (double)rounds * positions.size() * 2;
+    printf("%-22s %8.2f ns/test    %8.1f M/s  in check %lld\n", name,
+           seconds * 1e9 / tests, tests / seconds / 1e6, hits);
+}
+
+static void benchCheckDetection()
+{
+    vector<Position> positions;
+    for (const char *fen : middlegames)
+    {
+        Position pos;
+        if (pos.setFromFen(fen))
+            positions.push_back(pos);
+    }
+
+    printf("\nCheck detection (%d middlegame positions, both kings)\n", (int)positions.size());
+    timeCheckDetection("forward piece scan", positions, forwardInCheck);
+    timeCheckDetection("reverse super-piece", positions, reverseInCheck);
+}
+
+const int evalbenchplies = 16;
+const int evalbenchrounds = 200;
+
+// Positions along random games from each middlegame, so evaluation sees a
+// spread of material and phase.
+static vector<Position> makeEvalPositions()
+{
+    vector<Position> positions;
+    Bitboard seed = 0x9E3779B97F4A7C15ULL;
+    while ((int)positions.size() < benchsamples)
+    {
+        for (const char *fen : middlegames)
+        {
+            Position pos;
+            if (!pos.setFromFen(fen))
+                continue;
+            UndoInfo undo;
+            for (int ply = 0; ply < evalbenchplies; ply++)
+            {
+                MoveList list;
+                generateLegalMoves(pos, list);
+                if (list.size() == 0)
+                    break;
+                pos.make(list[(int)(nextRandom(seed) % list.size())], undo);
+                positions.push_back(pos);
+            }
+        }
+    }
+    return positions;
+}
+
+template <typename Evaluator>
+static void timeEvaluations(const char *name, const vector<Position> &positions, Evaluator evaluator)
+{
+    long long checksum = 0;
+    auto start = chrono::steady_clock::now();
+    for (int round = 0; round < evalbenchrounds; round++)
+    {
+        for (const Position &pos : positions)
+            checksum += evaluator(pos);
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    double evaluations = (double)evalbenchrounds * positions.size();
+    printf("%-22s %8.2f ns/eval  %8.1f M/s  checksum %lld\n", name, seconds * 1e9 / evaluations,
+           evaluations / seconds / 1e6, checksum);
+}
+
+static int blendScores(const Position &pos, int mg, int eg, int phase)
+{
+    phase = min(phase, maxphase);
+    int score = (mg * phase + eg * (maxphase - phase)) / maxphase;
+    return pos.sideToMove() == colorwhite ? score : -score;
+}
+
+// The incremental sums against rescanning every piece at each leaf, which
+// is what make/unmake saves; then the full evaluation with the pawn terms
+// computed every time and taken from a pawn hash table.
+static void benchEval()
+{
+    printf("\nEvaluation\n");
+    vector<Position> positions = makeEvalPositions();
+    timeEvaluations("pst incremental", positions, [](const Position &pos)
+                    { return blendScores(pos, pos.middlegameScore(), pos.endgameScore(), pos.gamePhase()); });
+    timeEvaluations("pst rescan", positions, [](const Position &pos)
+                    {
+                        int mg, eg, phase;
+                        pos.computeScores(mg, eg, phase);
+                        return blendScores(pos, mg, eg, phase);
+                    });
+    timeEvaluations("pawns computed", positions, [](const Position &pos) { return evaluate(pos); });
+    PawnHashTable pawns;
+    timeEvaluations("pawns hashed", positions, [&pawns](const Position &pos) { return evaluate(pos, pawns); });
+    printf("pawn hash hits %.1f%%\n", pawns.stats().hitRate() * 100);
+}
+
+const int searchbenchdepth = 10;
+const int searchbenchhashmb = 16;
+
+// Fixed-depth searches, so node counts are repeatable and time-to-depth is
+// comparable between builds.
+static void benchSearch()
+{
+    printf("\nSearch (depth %d)\n", searchbenchdepth);
+    TranspositionTable tt(searchbenchhashmb);
+    Search search(tt);
+    unsigned long long totalNodes = 0;
+    double totalSeconds = 0;
+    unsigned long long failHighs = 0;
+    unsigned long long failHighsFirst = 0;
+    unsigned long long movesGenerated = 0;
+    PawnHashStats pawnStats = {};
+    for (const char *fen : middlegames)
+    {
+        Position pos;
+        if (!pos.setFromFen(fen))
+            continue;
+        tt.clear();
+        search.prepare();
+        SearchInfo info = search.think(pos, vector<Bitboard>(), {searchbenchdepth, 0, 0});
+        pawnStats.probes += info.pawnStats.probes;
+        pawnStats.hits += info.pawnStats.hits;
+        totalNodes += info.nodes;
+        totalSeconds += info.seconds;
+        failHighs += info.failHighs;
+        failHighsFirst += info.failHighsFirst;
+        movesGenerated += info.movesGenerated;
+        printf("%-72s %10llu nodes %7.3f s %8.1f knps  tt hits %4.1f%% collisions %llu full %d  fh1 %4.1f%%  "
+               "gen/node %.2f  pawn hits %4.1f%%\n",
+               fen, info.nodes, info.seconds, info.nps() / 1000, info.ttStats.hitRate() * 100,
+               info.ttStats.collisions, info.hashfull, info.failHighFirstRate() * 100, info.movesPerNode(),
+               info.pawnStats.hitRate() * 100);
+    }
+    printf("%-72s %10llu nodes %7.3f s %8.1f knps  fh1 %4.1f%%  gen/node %.2f  pawn hits %4.1f%%\n", "total",
+           totalNodes, totalSeconds, totalNodes / totalSeconds / 1000,
+           failHighs ? 100.0 * failHighsFirst / failHighs : 0, (double)movesGenerated / totalNodes,
+           pawnStats.hitRate() * 100);
+}
+
+// The same searches with static exchange pruning of quiescence captures on
+// and off; without it every capture sequence is searched to the end.
+static void benchSee()
+{
+    printf("\nQuiescence SEE pruning (depth %d)\n", searchbenchdepth);
+    TranspositionTable tt(searchbenchhashmb);
+    Search search(tt);
+    for (bool pruning : {true, false})
+    {
+        SearchOptions options;
+        options.seePruning = pruning;
+        search.setOptions(options);
+        unsigned long long nodes = 0;
+        unsigned long long qnodes = 0;
+        double seconds = 0;
+        for (const char *fen : middlegames)
+        {
+            Position pos;
+            if (!pos.setFromFen(fen))
+                continue;
+            tt.clear();
+            search.prepare();
+            SearchInfo info = search.think(pos, vector<Bitboard>(), {searchbenchdepth, 0, 0});
+            nodes += info.nodes;
+            qnodes += info.qnodes;
+            seconds += info.seconds;
+        }
+        printf("see %-3s %12llu nodes %12llu qnodes (%4.1f%%) %8.3f s %8.1f knps\n", pruning ? "on" : "off", nodes,
+               qnodes, 100.0 * qnodes / nodes, seconds, nodes / seconds / 1000);
+    }
+}
+
+const int selectivebenchdepth = 8;
+
+struct SelectiveConfig
+{
+    const char *name;
+    bool nullMove;
+    bool lateMoveReductions;
+    bool futilityPruning;
+};
+
+static const SelectiveConfig selectiveConfigs[] = {
+    {"none", false, false, false},  {"null move", true, false, false}, {"lmr", false, true, false},
+    {"futility", false, false, true}, {"all", true, true, true},
+};
+
+// Time to a fixed depth and effective branching factor with each selective
+// feature alone, none and all. The branching factor is averaged over the
+// positions; the mate-in-few endgame is left out of it.
+static void benchSelectivity()
+{
+    printf("\nSelective search (depth %d)\n", selectivebenchdepth);
+    TranspositionTable tt(searchbenchhashmb);
+    Search search(tt);
+    double baseline = 0;
+    for (const SelectiveConfig &config : selectiveConfigs)
+    {
+        SearchOptions options;
+        options.nullMove = config.nullMove;
+        options.lateMoveReductions = config.lateMoveReductions;
+        options.futilityPruning = config.futilityPruning;
+        search.setOptions(options);
+        unsigned long long nodes = 0;
+        double seconds = 0;
+        double branching = 0;
+        int measured = 0;
+        for (const char *fen : middlegames)
+        {
+            Position pos;
+            if (!pos.setFromFen(fen))
+                continue;
+            tt.clear();
+            search.prepare();
+            SearchInfo info = search.think(pos, vector<Bitboard>(), {selectivebenchdepth, 0, 0});
+            nodes += info.nodes;
+            seconds += info.seconds;
+            if (info.branchingFactor() > 0 && info.depth == selectivebenchdepth)
+            {
+                branching += info.branchingFactor();
+                measured++;
+            }
+        }
+        if (baseline == 0)
+            baseline = seconds;
+        printf("%-10s %12llu nodes %8.3f s  ebf %5.2f  speedup %6.2f\n", config.name, nodes, seconds,
+               measured ? branching / measured : 0, baseline / seconds);
+    }
+}
+
+const char *nnuebenchfile = "bench.nnue";
+const int nnuebenchseed = 12345;
+
+// A random game from a middlegame, played forward one move at a time as in
+// the search.
+struct EvalLine
+{
+    Position root;
+    vector<Move> moves;
+};
+
+static vector<EvalLine> makeEvalLines()
+{
+    vector<EvalLine> lines;
+    Bitboard seed = 0x9E3779B97F4A7C15ULL;
+    int positions = 0;
+    while (positions < benchsamples)
+    {
+        for (const char *fen : middlegames)
+        {
+            EvalLine line;
+            if (!line.root.setFromFen(fen))
+                continue;
+            Position pos = line.root;
+            UndoInfo undo;
+            for (int ply = 0; ply < evalbenchplies; ply++)
+            {
+                MoveList list;
+                generateLegalMoves(pos, list);
+                if (list.size() == 0)
+                    break;
+                Move m = list[(int)(nextRandom(seed) % list.size())];
+                pos.make(m, undo);
+                line.moves.push_back(m);
+            }
+            positions += (int)line.moves.size();
+            lines.push_back(line);
+        }
+    }
+    return lines;
+}
+
+// Makes each line's moves and evaluates after every one, with the network's
+// accumulators updated from the parent ply, or with the classical
+// evaluation when net is null. Make and unmake are timed in both.
+static void timeLines(const char *name, const vector<EvalLine> &lines, const Network *net, AccumulatorStack &stack)
+{
+    static PawnHashTable pawns;
+    long long checksum = 0;
+    double evaluations = 0;
+    auto start = chrono::steady_clock::now();
+    for (const EvalLine &line : lines)
+    {
+        Position pos = line.root;
+        if (net)
+            stack.reset(*net, pos);
+        UndoInfo undo[evalbenchplies];
+        AttackState attacks[evalbenchplies];
+        int count = (int)line.moves.size();
+        for (int round = 0; round < evalbenchrounds; round++)
+        {
+            for (int i = 0; i < count; i++)
+            {
+                if (net)
+                    stack.push(pos, line.moves[i]);
+                pos.make(line.moves[i], undo[i], attacks[i]);
+                checksum += net ? stack.evaluate(*net, pos) : evaluate(pos, pawns);
+            }
+            for (int i = count - 1; i >= 0; i--)
+            {
+                pos.unmake(line.moves[i], undo[i], attacks[i]);
+                if (net)
+                    stack.pop();
+            }
+        }
+        evaluations += (double)evalbenchrounds * count;
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    printf("%-22s %8.2f ns/eval  %8.1f M/s  checksum %lld\n", name, seconds * 1e9 / evaluations,
+           evaluations / seconds / 1e6, checksum);
+}
+
+// Network evaluation at every instruction set the CPU has, against the
+// classical evaluation. The weights are random, so only speed means
+// anything; checksums must match across instruction sets. The network goes
+// through a file so loading by mapping is exercised too.
+static void benchNnue()
+{
+    printf("\nNNUE evaluation\n");
+    Network generated;
+    generated.randomize(nnuebenchseed);
+    Network net;
+    if (!generated.save(nnuebenchfile) || !net.load(nnuebenchfile))
+    {
+        printf("could not write and map %s\n", nnuebenchfile);
+        remove(nnuebenchfile);
+        return;
+    }
+    remove(nnuebenchfile);
+
+    vector<Position> positions = makeEvalPositions();
+    vector<EvalLine> lines = makeEvalLines();
+    static AccumulatorStack stack;
+    int best = cpuSimdLevel();
+    timeLines("classic make+eval", lines, nullptr, stack);
+    for (int level = simdscalar; level <= best; level++)
+    {
+        selectSimd(level);
+        string incremental = string(simdName(level)) + " make+eval";
+        string refresh = string(simdName(level)) + " refresh";
+        timeLines(incremental.c_str(), lines, &net, stack);
+        timeEvaluations(refresh.c_str(), positions, [&net](const Position &pos) { return net.evaluate(pos); });
+    }
+    selectSimd(best);
+
+    TranspositionTable tt(searchbenchhashmb);
+    Search search(tt);
+    search.setNetwork(&net);
+    for (bool nnue : {false, true})
+    {
+        SearchOptions options;
+        options.nnue = nnue;
+        search.setOptions(options);
+        unsigned long long nodes = 0;
+        double seconds = 0;
+        for (const char *fen : middlegames)
+        {
+            Position pos;
+            if (!pos.setFromFen(fen))
+                continue;
+            tt.clear();
+            search.prepare();
+            SearchInfo info = search.think(pos, vector<Bitboard>(), {selectivebenchdepth, 0, 0});
+            nodes += info.nodes;
+            seconds += info.seconds;
+        }
+        printf("search %-6s %12llu nodes %8.3f s %8.1f knps\n", nnue ? simdName(best) : "classic", nodes, seconds,
+               nodes / seconds / 1000);
+    }
+}
+
+const int smpbenchdepth = 11;
+const int smpthreadcounts[] = {1, 2, 4, 8, 16};
+
+// Lazy SMP is judged by time to reach a fixed depth, not by nodes per second:
+// helpers add nodes, and only the ones that fill the table with useful
+// entries make the main thread finish sooner.
+static void benchSmp()
+{
+    printf("\nLazy SMP time to depth %d (%u hardware threads)\n", smpbenchdepth, thread::hardware_concurrency());
+    TranspositionTable tt(searchbenchhashmb);
+    double baseline = 0;
+    for (int threads : smpthreadcounts)
+    {
+        Search search(tt, threads);
+        unsigned long long nodes = 0;
+        double seconds = 0;
+        for (const char *fen : middlegames)
+        {
+            Position pos;
+            if (!pos.setFromFen(fen))
+                continue;
+            tt.clear();
+            search.prepare();
+            SearchInfo info = search.think(pos, vector<Bitboard>(), {smpbenchdepth, 0, 0});
+            nodes += info.nodes;
+            seconds += info.seconds;
+        }
+        if (threads == 1)
+            baseline = seconds;
+        printf("%2d threads %12llu nodes %8.3f s %8.1f knps  speedup %5.2f\n", threads, nodes, seconds,
+               nodes / seconds / 1000, baseline / seconds);
+    }
+}
+
+int main()
+{
+    vector<Sample> samples = makeSamples();
+    benchSliders(samples);
+    benchCheckDetection();
+    benchEval();
+    benchSearch();
+    benchSee();
+    benchSelectivity();
+    benchNnue();
+    benchSmp();
+    return 0;
+}
@@ -0,0 +1,179 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include "types.h"
+
+struct Magic
+{
+    Bitboard mask;
+    Bitboard magic;
+    Bitboard *attacks;
+    unsigned shift;
+
+    unsigned index(Bitboard occupied) const;
+};
+
+extern Magic rookMagics[64];
+extern Magic bishopMagics[64];
+extern bool usePext;
+
+// Fills the slider tables. With allowPext the BMI2 pext instruction is used for
+// indexing when the CPU supports it, otherwise the magic multiply is used.
+void initAttacks(bool allowPext = true);
+bool cpuHasPext();
+
+inline Bitboard pext(Bitboard src, Bitboard mask)
+{
+#if defined(__x86_64__) && defined(__GNUC__)
+    Bitboard result;
+    asm("pextq %2, %1, %0" : "=r"(result) : "r"(src), "r"(mask));
+    return result;
+#else
+    (void)src;
+    (void)mask;
+    return 0;
+#endif
+}
+
+inline unsigned Magic::index(Bitboard occupied) const
+{
+    if (usePext)
+        return (unsigned)pext(occupied, mask);
+    return (unsigned)(((occupied & mask) * magic) >> shift);
+}
+
+inline Bitboard rookAttacks(int sq, Bitboard occupied)
+{
+    const Magic &m = rookMagics[sq];
+    return m.attacks[m.index(occupied)];
+}
+
+inline Bitboard bishopAttacks(int sq, Bitboard occupied)
+{
+    const Magic &m = bishopMagics[sq];
+    return m.attacks[m.index(occupied)];
+}
+
+inline Bitboard queenAttacks(int sq, Bitboard occupied)
+{
+    return rookAttacks(sq, occupied) | bishopAttacks(sq, occupied);
+}
+
+Bitboard rayRookAttacks(int sq, Bitboard occupied);
+Bitboard rayBishopAttacks(int sq, Bitboard occupied);
+
+// Leaper and line tables are built by the compiler, so they need no init call.
+struct LeaperTables
+{
+    Bitboard knight[64];
+    Bitboard king[64];
+    Bitboard pawn[2][64];
+};
+
+struct LineTables
+{
+    Bitboard between[64][64];
+    Bitboard line[64][64];
+};
+
+constexpr bool onBoard(int x, int y) { return x >= 0 && x < 8 && y >= 0 && y < 8; }
+
+constexpr Bitboard stepAttacks(int sq, const int (&steps)[8][2], int count)
+{
+    Bitboard attacks = 0;
+    for (int i = 0; i < count; i++)
+    {
+        int x = squareX(sq) + steps[i][0];
+        int y = squareY(sq) + steps[i][1];
+        if (onBoard(x, y))
+            attacks |= squareBit(makeSquare(x, y));
+    }
+    return attacks;
+}
+
+constexpr LeaperTables makeLeaperTables()
+{
+    const int knightSteps[8][2] = {{1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}};
+    const int kingSteps[8][2] = {{1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}};
+    const int whitePawnSteps[8][2] = {{-1, -1}, {1, -1}};
+    const int blackPawnSteps[8][2] = {{-1, 1}, {1, 1}};
+
+    LeaperTables tables{};
+    for (int sq = 0; sq < 64; sq++)
+    {
+        tables.knight[sq] = stepAttacks(sq, knightSteps, 8);
+        tables.king[sq] = stepAttacks(sq, kingSteps, 8);
+        tables.pawn[colorwhite][sq] = stepAttacks(sq, whitePawnSteps, 2);
+        tables.pawn[colorblack][sq] = stepAttacks(sq, blackPawnSteps, 2);
+    }
+    return tables;
+}
+
+constexpr LineTables makeLineTables()
+{
+    const int directions[8][2] = {{1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}};
+
+    LineTables tables{};
+    for (int from = 0; from < 64; from++)
+    {
+        for (int d = 0; d < 8; d++)
+        {
+            int dx = directions[d][0];
+            int dy = directions[d][1];
+
+            Bitboard fullLine = squareBit(from);
+            for (int sign = -1; sign <= 1; sign += 2)
+            {
+                int x = squareX(from) + sign * dx;
+                int y = squareY(from) + sign * dy;
+                while (onBoard(x, y))
+                {
+                    fullLine |= squareBit(makeSquare(x, y));
+                    x += sign * dx;
+                    y += sign * dy;
+                }
+            }
+
+            Bitboard path = 0;
+            int x = squareX(from) + dx;
+            int y = squareY(from) + dy;
+            while (onBoard(x, y))
+            {
+                int to = makeSquare(x, y);
+                tables.between[from][to] = path;
+                tables.line[from][to] = fullLine;
+                path |= squareBit(to);
+                x += dx;
+                y += dy;
+            }
+        }
+    }
+    return tables;
+}
+
+inline constexpr LeaperTables leaperTables = makeLeaperTables();
+inline constexpr LineTables lineTables = makeLineTables();
+
+inline Bitboard pawnAttacks(int color, int sq) { return leaperTables.pawn[color][sq]; }
+inline Bitboard knightAttacks(int sq) { return leaperTables.knight[sq]; }
+inline Bitboard kingAttacks(int sq) { return leaperTables.king[sq]; }
+
+// Squares strictly between two aligned squares, or 0 when they are not aligned.
+inline Bitboard betweenBB(int a, int b) { return lineTables.between[a][b]; }
+// The whole board line through two aligned squares, or 0 when they are not aligned.
+inline Bitboard lineBB(int a, int b) { return lineTables.line[a][b]; }
+
+const Bitboard fileA = 0x0101010101010101ULL;
+const Bitboard fileH = fileA << 7;
+
+// Squares attacked by a whole set of pawns of one colour.
+inline Bitboard pawnSetAttacks(int color, Bitboard pawns)
+{
+    if (color == colorwhite)
+        return ((pawns & ~fileA) >> 9) | ((pawns & ~fileH) >> 7);
+    return ((pawns & ~fileA) << 7) | ((pawns & ~fileH) << 9);
+}
+
+Bitboard pieceAttacks(int color, int type, int sq, Bitboard occupied);
+
+#endif
@@ -0,0 +1,49 @@
+#include "eval.h"
+#include "pst.h"
+#include <algorithm>
+using namespace std;
+
+// Endgame bonus for a passed pawn whose next square is empty, by rank from
+// its own side.
+inline constexpr int freePassedEg[8] = {0, 0, 2, 5, 10, 20, 35, 0};
+
+// The pawn terms that also depend on the other pieces, added to the cached
+// ones.
+static int blend(const Position &pos, const PawnEntry &pawns)
+{
+    int mg = pos.middlegameScore() + pawns.mgScore;
+    int eg = pos.endgameScore() + pawns.egScore;
+    for (int color = colorwhite; color <= colorblack; color++)
+    {
+        int sign = color == colorwhite ? 1 : -1;
+        int king = pos.kingSquare(color);
+        int kingRank = color == colorwhite ? 7 - squareY(king) : squareY(king);
+        if (king != nosquare && kingRank <= 1)
+            mg += sign * pawns.shield[color][squareX(king)];
+
+        Bitboard passed = pawns.passed[color];
+        while (passed)
+        {
+            int sq = popLsb(passed);
+            int stop = color == colorwhite ? sq - 8 : sq + 8;
+            if (!(pos.occupied() & squareBit(stop)))
+                eg += sign * freePassedEg[color == colorwhite ? 7 - squareY(sq) : squareY(sq)];
+        }
+    }
+
+    int phase = min(pos.gamePhase(), maxphase);
+    int score = (mg * phase + eg * (maxphase - phase)) / maxphase;
+    return pos.sideToMove() == colorwhite ? score : -score;
+}
+
+int evaluate(const Position &pos)
+{
+    PawnEntry pawns;
+    evaluatePawns(pos, pawns);
+    return blend(pos, pawns);
+}
+
+int evaluate(const Position &pos, PawnHashTable &pawns)
+{
+    return blend(pos, pawns.probe(pos));
+}
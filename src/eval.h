@@ -0,0 +1,18 @@
+#ifndef EVAL_H
+#define EVAL_H
+
+#include "pawns.h"
+#include "position.h"
+
+// Centipawn values indexed by piece type, for exchanges; the king is never
+// traded.
+inline constexpr int pieceValues[piecetypes] = {100, 500, 320, 330, 900, 0};
+
+// Static score in centipawns from the side to move's point of view: the
+// position's middle-game and endgame sums plus the pawn-structure terms,
+// blended by game phase. This one computes the pawn terms afresh.
+int evaluate(const Position &pos);
+// The same score with the pawn terms taken from a pawn hash table.
+int evaluate(const Position &pos, PawnHashTable &pawns);
+
+#endif
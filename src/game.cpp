@@ -4,29 +4,38 @@
 #include <ctime>
 #include <cstring>
 #include <vector>
+#include <cctype>
+#include <atomic>
+#include <thread>
+#include "bitboard.h"
+#include "history.h"
+#include "movegen.h"
+#include "nnue.h"
+#include "position.h"
+#include "search.h"
+#include "see.h"
+#include "timeman.h"
 using namespace std;
 
 const int windowlength = 1000;
 const int windowwidth = 998;
 const float tilesize = windowwidth / 8.0f;
 
-const int colorwhite = 0;
-const int colorblack = 1;
 const int stateplaying = 0;
 const int statewhitewon = 1;
 const int stateblackwon = 2;
 const int statestalemate = 3;
 const int staterecords = 4;
+const int statedrawrepetition = 5;
+const int statedrawfiftymove = 6;
 
-const int maxmoves = 100;
 const int namelength = 50;
 
-const int piecepawn = 0;
-const int piecerook = 1;
-const int pieceknight = 2;
-const int piecebishop = 3;
-const int piecequeen = 4;
-const int pieceking = 5;
+const int nocomputer = -1;
+const int enginemovetime = 2000;
+const int enginehashmb = 64;
+// Loaded if present; without it the engine uses the piece-square tables.
+const char *enginenetwork = "../nets/engine.nnue";
 
 class ChessBoard
 {
@@ -61,12 +70,11 @@ protected:
     sf::Texture texture;
     sf::Sprite sprite;
     int color;
-    bool hasMoved;
     int boardX, boardY;
     int pieceType;
 
 public:
-    ChessPiece(float x, float y, string i, int c, int type) : posX(x), posY(y), image(i), color(c), hasMoved(false), pieceType(type)
+    ChessPiece(float x, float y, string i, int c, int type) : posX(x), posY(y), image(i), color(c), pieceType(type)
     {
         boardX = (int)(x / tilesize);
         boardY = (int)(y / tilesize);
@@ -96,16 +104,13 @@ public:
         sprite.setPosition(posX + tilesize / 4, posY + tilesize / 4);
     }
 
-    void setHasMoved(bool moved) { hasMoved = moved; }
     sf::Sprite &getSprite() { return sprite; }
     bool contains(float x, float y) { return sprite.getGlobalBounds().contains(x, y); }
     int getColor() const { return color; }
     int getBoardX() const { return boardX; }
     int getBoardY() const { return boardY; }
-    bool getHasMoved() const { return hasMoved; }
     int getPieceType() const { return pieceType; }
 
-    virtual bool isValidMove(int toX, int toY, ChessPiece *board[8][8]) = 0;
     virtual ~ChessPiece() {}
 };
 
@@ -113,242 +118,36 @@ class Pawn : public ChessPiece
 {
 public:
     Pawn(float x, float y, string i, int c) : ChessPiece(x, y, i, c, piecepawn) {}
-
-    bool isValidMove(int toX, int toY, ChessPiece *board[8][8]) override
-    {
-        if (!board || toX < 0 || toX >= 8 || toY < 0 || toY >= 8)
-            return false;
-        int direction = (color == colorwhite) ? -1 : 1;
-        int startRow = (color == colorwhite) ? 6 : 1;
-
-        if (toX == boardX && toY == boardY + direction && !board[toX][toY])
-        {
-            return true;
-        }
-
-        if (toX == boardX && toY == boardY + 2 * direction &&
-            !board[toX][toY] && !board[toX][boardY + direction] &&
-            boardY == startRow && !hasMoved)
-        {
-            return true;
-        }
-
-        if ((toX == boardX + 1 || toX == boardX - 1) &&
-            toY == boardY + direction &&
-            board[toX][toY] && board[toX][toY]->getColor() != color)
-        {
-            return true;
-        }
-
-        return false;
-    }
 };
 
 class Rook : public ChessPiece
 {
 public:
     Rook(float x, float y, string i, int c) : ChessPiece(x, y, i, c, piecerook) {}
-
-    bool isValidMove(int toX, int toY, ChessPiece *board[8][8]) override
-    {
-        if (!board || toX < 0 || toX >= 8 || toY < 0 || toY >= 8)
-            return false;
-        if (toX == boardX && toY == boardY)
-            return false;
-        if (toX != boardX && toY != boardY)
-            return false;
-
-        if (toX == boardX)
-        {
-            int step = (toY > boardY) ? 1 : -1;
-            for (int y = boardY + step; y != toY; y += step)
-            {
-                if (board[toX][y])
-                    return false;
-            }
-        }
-        else
-        {
-            int step = (toX > boardX) ? 1 : -1;
-            for (int x = boardX + step; x != toX; x += step)
-            {
-                if (board[x][toY])
-                    return false;
-            }
-        }
-
-        if (!board[toX][toY] || board[toX][toY]->getColor() != color)
-        {
-            return true;
-        }
-
-        return false;
-    }
 };
 
 class Knight : public ChessPiece
 {
 public:
     Knight(float x, float y, string i, int c) : ChessPiece(x, y, i, c, pieceknight) {}
-
-    bool isValidMove(int toX, int toY, ChessPiece *board[8][8]) override
-    {
-        if (!board || toX < 0 || toX >= 8 || toY < 0 || toY >= 8)
-            return false;
-        int dx = abs(toX - boardX);
-        int dy = abs(toY - boardY);
-
-        if ((dx == 2 && dy == 1) || (dx == 1 && dy == 2))
-        {
-            if (!board[toX][toY] || board[toX][toY]->getColor() != color)
-            {
-                return true;
-            }
-        }
-
-        return false;
-    }
 };
 
 class Bishop : public ChessPiece
 {
 public:
     Bishop(float x, float y, string i, int c) : ChessPiece(x, y, i, c, piecebishop) {}
-
-    bool isValidMove(int toX, int toY, ChessPiece *board[8][8]) override
-    {
-        if (!board || toX < 0 || toX >= 8 || toY < 0 || toY >= 8)
-            return false;
-        if (toX == boardX && toY == boardY)
-            return false;
-        if (abs(toX - boardX) != abs(toY - boardY))
-            return false;
-
-        int stepX = (toX > boardX) ? 1 : -1;
-        int stepY = (toY > boardY) ? 1 : -1;
-
-        int x = boardX + stepX;
-        int y = boardY + stepY;
-        while (x != toX && y != toY)
-        {
-            if (board[x][y])
-                return false;
-            x += stepX;
-            y += stepY;
-        }
-
-        if (!board[toX][toY] || board[toX][toY]->getColor() != color)
-        {
-            return true;
-        }
-
-        return false;
-    }
 };
 
 class Queen : public ChessPiece
 {
 public:
     Queen(float x, float y, string i, int c) : ChessPiece(x, y, i, c, piecequeen) {}
-
-    bool isValidMove(int toX, int toY, ChessPiece *board[8][8]) override
-    {
-        if (!board || toX < 0 || toX >= 8 || toY < 0 || toY >= 8)
-            return false;
-        if (toX == boardX && toY == boardY)
-            return false;
-        if (toX != boardX && toY != boardY &&
-            abs(toX - boardX) != abs(toY - boardY))
-        {
-            return false;
-        }
-
-        if (toX == boardX)
-        {
-            int step = (toY > boardY) ? 1 : -1;
-            for (int y = boardY + step; y != toY; y += step)
-            {
-                if (board[toX][y])
-                    return false;
-            }
-        }
-        else if (toY == boardY)
-        {
-            int step = (toX > boardX) ? 1 : -1;
-            for (int x = boardX + step; x != toX; x += step)
-            {
-                if (board[x][toY])
-                    return false;
-            }
-        }
-        else
-        {
-            int stepX = (toX > boardX) ? 1 : -1;
-            int stepY = (toY > boardY) ? 1 : -1;
-
-            int x = boardX + stepX;
-            int y = boardY + stepY;
-            while (x != toX && y != toY)
-            {
-                if (board[x][y])
-                    return false;
-                x += stepX;
-                y += stepY;
-            }
-        }
-
-        if (!board[toX][toY] || board[toX][toY]->getColor() != color)
-        {
-            return true;
-        }
-
-        return false;
-    }
 };
 
 class King : public ChessPiece
 {
 public:
     King(float x, float y, string i, int c) : ChessPiece(x, y, i, c, pieceking) {}
-
-    bool isValidMove(int toX, int toY, ChessPiece *board[8][8]) override
-    {
-        if (!board || toX < 0 || toX >= 8 || toY < 0 || toY >= 8)
-            return false;
-        int dx = abs(toX - boardX);
-        int dy = abs(toY - boardY);
-
-        if (dx <= 1 && dy <= 1 && (dx != 0 || dy != 0))
-        {
-            if (!board[toX][toY] || board[toX][toY]->getColor() != color)
-            {
-                return true;
-            }
-        }
-
-        if (!hasMoved && dy == 0 && dx == 2)
-        {
-            int rookX = (toX > boardX) ? 7 : 0;
-            int step = (toX > boardX) ? 1 : -1;
-            int rookToX = (toX > boardX) ? 5 : 3;
-
-            if (!board[rookX][boardY] || board[rookX][boardY]->getPieceType() != piecerook ||
-                board[rookX][boardY]->getHasMoved())
-            {
-                return false;
-            }
-
-            for (int x = boardX + step; x != rookX; x += step)
-            {
-                if (board[x][boardY])
-                    return false;
-            }
-
-            return true;
-        }
-
-        return false;
-    }
 };
 
 class ChessGame
@@ -356,6 +155,7 @@ class ChessGame
     sf::RenderWindow window;
     ChessBoard *board;
     ChessPiece *pieceBoard[8][8];
+    Position position;
 
     ChessPiece *pieces[32];
     int pieceCount;
@@ -368,9 +168,8 @@ class ChessGame
 
     sf::RectangleShape highlight;
     sf::CircleShape moveIndicator;
-
-    ChessPiece *lastDoubleMovedPawn;
-    int lastMoveTurn;
+    sf::RectangleShape hangingHighlight;
+    bool showHanging;
 
     bool useTime;
     float whiteTime;
@@ -381,9 +180,8 @@ class ChessGame
     sf::Text blackTimerText;
     bool fontLoaded;
 
-    int *moveHistory;
-    int moveCount;
-    int moveCapacity;
+    MoveHistory moveHistory;
+    MoveHistory redoHistory;
 
     char *whitePlayerName;
     char *blackPlayerName;
@@ -392,11 +190,23 @@ class ChessGame
     vector<ChessPiece *> capturedPieces;
     bool keyPressed;
 
+    int computerColor;
+    TranspositionTable engineTable;
+    Network engineNetwork;
+    Search engine;
+    thread engineThread;
+    atomic<bool> engineDone;
+    bool engineThinking;
+    SearchInfo engineResult;
+    SearchInfo engineInfo;
+    sf::Text engineText;
+
 public:
     ChessGame(bool timed = false) : pieceCount(0), selectedPiece(nullptr), currentTurn(colorwhite),
-                                    gameState(stateplaying), lastDoubleMovedPawn(nullptr), lastMoveTurn(0),
-                                    useTime(timed), whiteTime(600.0f), blackTime(600.0f), moveCount(0),
-                                    moveCapacity(maxmoves), fontLoaded(false), keyPressed(false)
+                                    gameState(stateplaying), showHanging(false), useTime(timed), whiteTime(600.0f), blackTime(600.0f),
+                                    fontLoaded(false), keyPressed(false), computerColor(nocomputer),
+                                    engineTable(0), engine(engineTable, 1),
+                                    engineDone(false), engineThinking(false), engineResult(), engineInfo()
     {
         whitePlayerName = new char[namelength];
         blackPlayerName = new char[namelength];
@@ -410,10 +220,47 @@ public:
             blackPlayerName[i] = '\0';
         }
 
-        cout << "Enter White player's name: ";
-        cin.getline(whitePlayerName, namelength);
-        cout << "Enter Black player's name: ";
-        cin.getline(blackPlayerName, namelength);
+        char computerChoice[namelength];
+        cout << "Computer plays (w/b, Enter for two players): ";
+        cin.getline(computerChoice, namelength);
+        if (tolower(computerChoice[0]) == 'w')
+            computerColor = colorwhite;
+        else if (tolower(computerChoice[0]) == 'b')
+            computerColor = colorblack;
+        // Two-player games keep the engine at its one-bucket, one-thread minimum.
+        if (computerColor != nocomputer)
+        {
+            engineTable.resize(enginehashmb);
+            engine.setThreads(max(1, (int)thread::hardware_concurrency()));
+            if (engineNetwork.load(enginenetwork))
+            {
+                engine.setNetwork(&engineNetwork);
+                cout << "Engine evaluates with " << enginenetwork << " (" << simdName(activeSimd()) << ")" << endl;
+            }
+            else
+            {
+                cout << "Engine evaluates with piece-square tables" << endl;
+            }
+        }
+
+        if (computerColor == colorwhite)
+        {
+            strcpy(whitePlayerName, "Computer");
+        }
+        else
+        {
+            cout << "Enter White player's name: ";
+            cin.getline(whitePlayerName, namelength);
+        }
+        if (computerColor == colorblack)
+        {
+            strcpy(blackPlayerName, "Computer");
+        }
+        else
+        {
+            cout << "Enter Black player's name: ";
+            cin.getline(blackPlayerName, namelength);
+        }
 
         window.create(sf::VideoMode(windowlength, windowwidth), "Chess Game");
         if (!window.isOpen())
@@ -435,6 +282,8 @@ public:
         highlight.setFillColor(sf::Color(255, 255, 0, 100));
         moveIndicator.setRadius(tilesize / 6);
         moveIndicator.setFillColor(sf::Color(0, 255, 0, 100));
+        hangingHighlight.setSize(sf::Vector2f(tilesize, tilesize));
+        hangingHighlight.setFillColor(sf::Color(255, 0, 0, 90));
 
         for (int i = 0; i < 8; i++)
         {
@@ -448,18 +297,7 @@ public:
             pieces[i] = nullptr;
         }
 
-        moveHistory = new int[moveCapacity * 16];
-        if (!moveHistory)
-        {
-            window.close();
-            throw runtime_error("Memory allocation failed for moveHistory");
-        }
-        for (int i = 0; i < moveCapacity * 16; i++)
-        {
-            moveHistory[i] = -1;
-        }
-
-        if (useTime && font.loadFromFile("../fonts/arial.ttf"))
+        if ((useTime || computerColor != nocomputer) && font.loadFromFile("../fonts/arial.ttf"))
         {
             fontLoaded = true;
             whiteTimerText.setFont(font);
@@ -471,6 +309,11 @@ public:
             blackTimerText.setCharacterSize(30);
             blackTimerText.setFillColor(sf::Color(50, 50, 50));
             blackTimerText.setPosition(10, 10);
+
+            engineText.setFont(font);
+            engineText.setCharacterSize(20);
+            engineText.setFillColor(sf::Color(50, 50, 50));
+            engineText.setPosition(windowlength - 330, windowwidth - 35);
         }
 
         initializePieces();
@@ -478,346 +321,287 @@ public:
 
     void initializePieces()
     {
-        for (int i = 0; i < 8; i++)
-        {
-            pieces[pieceCount] = new Pawn(i * tilesize, 6 * tilesize, "../textures/white_pawn.png", colorwhite);
-            pieceBoard[i][6] = pieces[pieceCount++];
-            pieces[pieceCount] = new Pawn(i * tilesize, 1 * tilesize, "../textures/black_pawn.png", colorblack);
-            pieceBoard[i][1] = pieces[pieceCount++];
-        }
-        pieces[pieceCount] = new Rook(0 * tilesize, 7 * tilesize, "../textures/white_rook.png", colorwhite);
-        pieceBoard[0][7] = pieces[pieceCount++];
-        pieces[pieceCount] = new Rook(7 * tilesize, 7 * tilesize, "../textures/white_rook.png", colorwhite);
-        pieceBoard[7][7] = pieces[pieceCount++];
-        pieces[pieceCount] = new Rook(0 * tilesize, 0 * tilesize, "../textures/black_rook.png", colorblack);
-        pieceBoard[0][0] = pieces[pieceCount++];
-        pieces[pieceCount] = new Rook(7 * tilesize, 0 * tilesize, "../textures/black_rook.png", colorblack);
-        pieceBoard[7][0] = pieces[pieceCount++];
-        pieces[pieceCount] = new Knight(1 * tilesize, 7 * tilesize, "../textures/white_knight.png", colorwhite);
-        pieceBoard[1][7] = pieces[pieceCount++];
-        pieces[pieceCount] = new Knight(6 * tilesize, 7 * tilesize, "../textures/white_knight.png", colorwhite);
-        pieceBoard[6][7] = pieces[pieceCount++];
-        pieces[pieceCount] = new Knight(1 * tilesize, 0 * tilesize, "../textures/black_knight.png", colorblack);
-        pieceBoard[1][0] = pieces[pieceCount++];
-        pieces[pieceCount] = new Knight(6 * tilesize, 0 * tilesize, "../textures/black_knight.png", colorblack);
-        pieceBoard[6][0] = pieces[pieceCount++];
-        pieces[pieceCount] = new Bishop(2 * tilesize, 7 * tilesize, "../textures/white_bishop.png", colorwhite);
-        pieceBoard[2][7] = pieces[pieceCount++];
-        pieces[pieceCount] = new Bishop(5 * tilesize, 7 * tilesize, "../textures/white_bishop.png", colorwhite);
-        pieceBoard[5][7] = pieces[pieceCount++];
-        pieces[pieceCount] = new Bishop(2 * tilesize, 0 * tilesize, "../textures/black_bishop.png", colorblack);
-        pieceBoard[2][0] = pieces[pieceCount++];
-        pieces[pieceCount] = new Bishop(5 * tilesize, 0 * tilesize, "../textures/black_bishop.png", colorblack);
-        pieceBoard[5][0] = pieces[pieceCount++];
-        pieces[pieceCount] = new Queen(3 * tilesize, 7 * tilesize, "../textures/white_queen.png", colorwhite);
-        pieceBoard[3][7] = pieces[pieceCount++];
-        pieces[pieceCount] = new Queen(3 * tilesize, 0 * tilesize, "../textures/black_queen.png", colorblack);
-        pieceBoard[3][0] = pieces[pieceCount++];
-        pieces[pieceCount] = new King(4 * tilesize, 7 * tilesize, "../textures/white_king.png", colorwhite);
-        pieceBoard[4][7] = pieces[pieceCount++];
-        pieces[pieceCount] = new King(4 * tilesize, 0 * tilesize, "../textures/black_king.png", colorblack);
-        pieceBoard[4][0] = pieces[pieceCount++];
+        position.setFromFen(startfen);
+        currentTurn = position.sideToMove();
+        updateSprites(~0ULL);
     }
 
-    void run()
+    ChessPiece *createPiece(int color, int type, int x, int y)
     {
-        if (useTime)
-        {
-            gameClock.restart();
+        static const char *colorNames[2] = {"white", "black"};
+        static const char *typeNames[piecetypes] = {"pawn", "rook", "knight", "bishop", "queen", "king"};
+        string texturePath = string("../textures/") + colorNames[color] + "_" + typeNames[type] + ".png";
+        float px = x * tilesize;
+        float py = y * tilesize;
+        switch (type)
+        {
+        case piecepawn:
+            return new Pawn(px, py, texturePath, color);
+        case piecerook:
+            return new Rook(px, py, texturePath, color);
+        case pieceknight:
+            return new Knight(px, py, texturePath, color);
+        case piecebishop:
+            return new Bishop(px, py, texturePath, color);
+        case piecequeen:
+            return new Queen(px, py, texturePath, color);
+        default:
+            return new King(px, py, texturePath, color);
         }
+    }
 
-        while (window.isOpen())
+    // Makes the sprites on the given squares match the position. Sprites taken
+    // off the board are parked in capturedPieces and reused before new ones are
+    // loaded, so captures, promotions and undo don't reload textures.
+    void updateSprites(Bitboard squares)
+    {
+        Bitboard scan = squares;
+        while (scan)
         {
-            sf::Event event;
-            while (window.pollEvent(event))
+            int sq = popLsb(scan);
+            ChessPiece *sprite = pieceBoard[squareX(sq)][squareY(sq)];
+            if (sprite && makePiece(sprite->getColor(), sprite->getPieceType()) != position.pieceAt(sq))
             {
-                if (event.type == sf::Event::Closed ||
-                    (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Escape))
-                {
-                    window.close();
-                }
-
-                handleGameEvents(event);
-            }
-
-            if (useTime && gameState == stateplaying)
-            {
-                float deltaTime = gameClock.restart().asSeconds();
-                if (currentTurn == colorwhite)
-                {
-                    whiteTime -= deltaTime;
-                    if (whiteTime <= 0)
-                    {
-                        gameState = stateblackwon;
-                        saveGameRecord();
-                    }
-                }
-                else
+                for (int i = 0; i < pieceCount; i++)
                 {
-                    blackTime -= deltaTime;
-                    if (blackTime <= 0)
+                    if (pieces[i] == sprite)
                     {
-                        gameState = statewhitewon;
-                        saveGameRecord();
+                        pieces[i] = nullptr;
+                        break;
                     }
                 }
+                capturedPieces.push_back(sprite);
+                pieceBoard[squareX(sq)][squareY(sq)] = nullptr;
             }
-
-            window.clear();
-            drawGame();
-            window.display();
         }
-    }
 
-    bool isKingInCheck(int playerColor, int kingX, int kingY, ChessPiece *board[8][8])
-    {
-        if (!board || kingX < 0 || kingX >= 8 || kingY < 0 || kingY >= 8)
-            return false;
-
-        for (int x = 0; x < 8; x++)
+        scan = squares;
+        while (scan)
         {
-            for (int y = 0; y < 8; y++)
+            int sq = popLsb(scan);
+            int x = squareX(sq);
+            int y = squareY(sq);
+            int piece = position.pieceAt(sq);
+            if (piece == nopiece || pieceBoard[x][y])
+                continue;
+
+            ChessPiece *sprite = nullptr;
+            for (int i = (int)capturedPieces.size() - 1; i >= 0; i--)
             {
-                ChessPiece *piece = board[x][y];
-                if (piece && piece->getColor() != playerColor)
+                ChessPiece *parked = capturedPieces[i];
+                if (parked && makePiece(parked->getColor(), parked->getPieceType()) == piece)
                 {
-                    if (piece->isValidMove(kingX, kingY, board))
-                    {
-                        return true;
-                    }
+                    sprite = parked;
+                    capturedPieces.erase(capturedPieces.begin() + i);
+                    break;
                 }
             }
-        }
-        return false;
-    }
+            if (sprite)
+                sprite->setPosition(x * tilesize, y * tilesize);
+            else
+                sprite = createPiece(colorOf(piece), typeOf(piece), x, y);
 
-    bool findKingPosition(int playerColor, int &kingX, int &kingY, ChessPiece *board[8][8])
-    {
-        if (!board)
-            return false;
-        for (int x = 0; x < 8; x++)
-        {
-            for (int y = 0; y < 8; y++)
+            pieceBoard[x][y] = sprite;
+            for (int i = 0; i < 32; i++)
             {
-                ChessPiece *piece = board[x][y];
-                if (piece && piece->getPieceType() == pieceking && piece->getColor() == playerColor)
+                if (!pieces[i])
                 {
-                    kingX = x;
-                    kingY = y;
-                    return true;
+                    pieces[i] = sprite;
+                    if (i >= pieceCount)
+                        pieceCount = i + 1;
+                    break;
                 }
             }
         }
-        return false;
     }
 
-    bool wouldKingBeInCheck(ChessPiece *piece, int fromX, int fromY, int toX, int toY, bool isEnPassant, bool isCastling)
+    void makeMove(Move move)
     {
-        if (!piece || !pieceBoard || toX < 0 || toX >= 8 || toY < 0 || toY >= 8 ||
-            fromX < 0 || fromX >= 8 || fromY < 0 || fromY >= 8)
-        {
-            return false;
-        }
-
-        int playerColor = piece->getColor();
-        ChessPiece *tempBoard[8][8];
-        for (int i = 0; i < 8; i++)
-            for (int j = 0; j < 8; j++)
-                tempBoard[i][j] = pieceBoard[i][j];
+        int mover = position.sideToMove();
+        HistoryEntry &entry = moveHistory.push();
+        entry.move = move;
+        position.make(move, entry.undo);
+
+        currentTurn = position.sideToMove();
+        updateSprites(changedSquares(move, mover));
+        checkGameState();
+    }
 
-        if (isEnPassant)
+    // The engine searches a copy of the position on a worker thread. run()
+    // polls for its answer and plays it through makeMove, as a mouse drop would.
+    void startEngine()
+    {
+        vector<Bitboard> keys;
+        for (int i = 0; i < moveHistory.size(); i++)
         {
-            tempBoard[toX][fromY] = nullptr;
+            keys.push_back(moveHistory[i].undo.key);
         }
-        else if (tempBoard[toX][toY])
+        SearchLimits limits = {0, enginemovetime, enginemovetime};
+        if (useTime)
         {
-            tempBoard[toX][toY] = nullptr;
+            float timeLeft = (computerColor == colorwhite) ? whiteTime : blackTime;
+            TimeAllocation allocation = allocateTime((int)(timeLeft * 1000), moveHistory.size() / 2 + 1);
+            limits.softTime = allocation.soft;
+            limits.hardTime = allocation.hard;
         }
 
-        if (isCastling)
-        {
-            int rookFromX = (toX > fromX) ? 7 : 0;
-            int rookToX = (toX > fromX) ? 5 : 3;
-            ChessPiece *rook = tempBoard[rookFromX][fromY];
-            if (rook)
-            {
-                tempBoard[rookFromX][fromY] = nullptr;
-                tempBoard[rookToX][fromY] = rook;
-            }
-        }
+        Position root = position;
+        engine.prepare();
+        engineDone = false;
+        engineThinking = true;
+        engineThread = thread([this, root, keys, limits]()
+                              {
+                                  engineResult = engine.think(root, keys, limits);
+                                  engineDone = true; });
+    }
 
-        tempBoard[fromX][fromY] = nullptr;
-        tempBoard[toX][toY] = piece;
+    void stopEngine()
+    {
+        if (!engineThinking)
+            return;
+        engine.stop();
+        engineThread.join();
+        engineThinking = false;
+    }
 
-        int kingX, kingY;
-        if (piece->getPieceType() == pieceking)
+    void updateEngine()
+    {
+        if (engineThinking && gameState != stateplaying)
         {
-            kingX = toX;
-            kingY = toY;
+            stopEngine();
         }
-        else
+        if (engineThinking && engineDone)
         {
-            if (!findKingPosition(playerColor, kingX, kingY, tempBoard))
+            engineThread.join();
+            engineThinking = false;
+            engineInfo = engineResult;
+
+            cout << "Computer: " << moveToString(engineInfo.bestMove) << "  depth " << engineInfo.depth
+                 << "  score " << engineInfo.score << "  nodes " << engineInfo.nodes
+                 << "  nps " << (long long)engineInfo.nps() << "  time " << engineInfo.seconds << "s"
+                 << "  tt hits " << (int)(engineInfo.ttStats.hitRate() * 100) << "% full " << engineInfo.hashfull
+                 << "  fh1 " << (int)(engineInfo.failHighFirstRate() * 100) << "%"
+                 << "  pv";
+            for (int i = 0; i < engineInfo.pvLength; i++)
             {
-                return false;
+                cout << " " << moveToString(engineInfo.pv[i]);
             }
-        }
+            cout << endl;
 
-        return isKingInCheck(playerColor, kingX, kingY, tempBoard);
-    }
-
-    bool isValidEnPassant(ChessPiece *pawn, int toX, int toY)
-    {
-        if (!pawn || pawn->getPieceType() != piecepawn || toX < 0 || toX >= 8 || toY < 0 || toY >= 8)
-            return false;
-
-        int direction = (pawn->getColor() == colorwhite) ? -1 : 1;
-        if (toY != pawn->getBoardY() + direction)
-            return false;
-
-        if (abs(toX - pawn->getBoardX()) == 1 && !pieceBoard[toX][toY])
-        {
-            ChessPiece *target = pieceBoard[toX][pawn->getBoardY()];
-            if (target && target == lastDoubleMovedPawn &&
-                target->getPieceType() == piecepawn &&
-                target->getColor() != pawn->getColor() &&
-                lastMoveTurn == (currentTurn == colorwhite ? colorblack : colorwhite))
+            if (engineInfo.bestMove != nomove)
             {
-                return true;
+                redoHistory.clear();
+                makeMove(engineInfo.bestMove);
             }
         }
-        return false;
-    }
-
-    bool hasLegalMoves(int playerColor)
-    {
-        if (!pieceBoard)
-            return false;
-        for (int fromX = 0; fromX < 8; fromX++)
+        if (!engineThinking && gameState == stateplaying && currentTurn == computerColor)
         {
-            for (int fromY = 0; fromY < 8; fromY++)
-            {
-                ChessPiece *piece = pieceBoard[fromX][fromY];
-                if (!piece || piece->getColor() != playerColor)
-                {
-                    continue;
-                }
-                for (int toX = 0; toX < 8; toX++)
-                {
-                    for (int toY = 0; toY < 8; toY++)
-                    {
-                        bool isEnPassant = isValidEnPassant(piece, toX, toY);
-                        bool isCastling = piece->getPieceType() == pieceking &&
-                                          abs(toX - fromX) == 2 && toY == fromY;
-                        if ((piece->isValidMove(toX, toY, pieceBoard) || isEnPassant) &&
-                            !wouldKingBeInCheck(piece, fromX, fromY, toX, toY, isEnPassant, isCastling))
-                        {
-                            return true;
-                        }
-                    }
-                }
-            }
+            startEngine();
         }
-        return false;
     }
 
-    void undoMove()
+    void run()
     {
-        if (moveCount <= 0)
-            return;
-
-        moveCount--;
-        int idx = moveCount * 16;
-
-        int pieceIdx = moveHistory[idx];
-        int fromX = moveHistory[idx + 1];
-        int fromY = moveHistory[idx + 2];
-        int toX = moveHistory[idx + 3];
-        int toY = moveHistory[idx + 4];
-        int capturedIdx = moveHistory[idx + 5];
-        bool isEnPassant = moveHistory[idx + 6] == 1;
-        bool isCastling = moveHistory[idx + 7] == 1;
-        int rookFromX = moveHistory[idx + 8];
-        int rookToX = moveHistory[idx + 9];
-        bool pieceHasMoved = moveHistory[idx + 10] == 1;
-        bool rookHasMoved = moveHistory[idx + 11] == 1;
-        int originalPieceType = moveHistory[idx + 12];
-        int promotedIdx = moveHistory[idx + 13];
-        int lastDoubleMovedPawnIdx = moveHistory[idx + 14];
-        int lastMoveTurnBefore = moveHistory[idx + 15];
-
-        ChessPiece *piece = pieceIdx >= 0 && pieceIdx < 32 ? pieces[pieceIdx] : nullptr;
-        if (!piece || fromX < 0 || fromX >= 8 || fromY < 0 || fromY >= 8 || toX < 0 || toX >= 8 || toY < 0 || toY >= 8)
-            return;
+        if (useTime)
+        {
+            gameClock.restart();
+        }
 
-        if (promotedIdx != -1 && originalPieceType == piecepawn)
+        while (window.isOpen())
         {
-            for (int i = 0; i < 32; i++)
+            sf::Event event;
+            while (window.pollEvent(event))
             {
-                if (pieces[i] == piece)
+                if (event.type == sf::Event::Closed ||
+                    (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Escape))
                 {
-                    string texturePath = (piece->getColor() == colorwhite) ? "../textures/white_pawn.png" : "../textures/black_pawn.png";
-                    ChessPiece *newPiece = new Pawn(fromX * tilesize, fromY * tilesize, texturePath, piece->getColor());
-                    newPiece->setHasMoved(pieceHasMoved);
-                    capturedPieces.push_back(pieces[i]);
-                    pieces[i] = newPiece;
-                    piece = newPiece;
-                    break;
+                    window.close();
                 }
+
+                handleGameEvents(event);
             }
-        }
 
-        pieceBoard[toX][toY] = nullptr;
-        pieceBoard[fromX][fromY] = piece;
-        piece->setPosition(fromX * tilesize, fromY * tilesize);
-        piece->setHasMoved(pieceHasMoved);
+            updateEngine();
 
-        if (capturedIdx >= 0 && capturedIdx < (int)capturedPieces.size())
-        {
-            ChessPiece *capturedPiece = capturedPieces[capturedIdx];
-            if (capturedPiece)
+            if (useTime && gameState == stateplaying)
             {
-                for (int i = 0; i < 32; i++)
+                float deltaTime = gameClock.restart().asSeconds();
+                if (currentTurn == colorwhite)
                 {
-                    if (!pieces[i])
+                    whiteTime -= deltaTime;
+                    if (whiteTime <= 0)
                     {
-                        pieces[i] = capturedPiece;
-                        break;
+                        gameState = stateblackwon;
+                        saveGameRecord();
                     }
                 }
-                if (isEnPassant)
-                {
-                    pieceBoard[toX][fromY] = capturedPiece;
-                    capturedPiece->setPosition(toX * tilesize, fromY * tilesize);
-                }
                 else
                 {
-                    pieceBoard[toX][toY] = capturedPiece;
-                    capturedPiece->setPosition(toX * tilesize, toY * tilesize);
+                    blackTime -= deltaTime;
+                    if (blackTime <= 0)
+                    {
+                        gameState = statewhitewon;
+                        saveGameRecord();
+                    }
                 }
-                capturedPieces[capturedIdx] = nullptr;
             }
+
+            window.clear();
+            drawGame();
+            window.display();
         }
+    }
+
+    bool isKingInCheck(int playerColor)
+    {
+        return position.inCheck(playerColor);
+    }
 
-        if (isCastling)
+    Move findLegalMove(int fromX, int fromY, int toX, int toY)
+    {
+        MoveList moves;
+        generateLegalMoves(position, moves);
+        int from = makeSquare(fromX, fromY);
+        int to = makeSquare(toX, toY);
+        for (Move m : moves)
         {
-            ChessPiece *rook = pieceBoard[rookToX][fromY];
-            if (rook && rookFromX >= 0 && rookFromX < 8 && rookToX >= 0 && rookToX < 8)
+            if (moveFrom(m) == from && moveTo(m) == to && (!isPromotion(m) || promotionType(m) == piecequeen))
             {
-                pieceBoard[rookToX][fromY] = nullptr;
-                pieceBoard[rookFromX][fromY] = rook;
-                rook->setPosition(rookFromX * tilesize, fromY * tilesize);
-                rook->setHasMoved(rookHasMoved);
+                return m;
             }
         }
+        return nomove;
+    }
 
-        lastDoubleMovedPawn = lastDoubleMovedPawnIdx >= 0 && lastDoubleMovedPawnIdx < 32 ? pieces[lastDoubleMovedPawnIdx] : nullptr;
-        lastMoveTurn = lastMoveTurnBefore;
+    bool hasLegalMoves(int playerColor)
+    {
+        return position.sideToMove() == playerColor && hasLegalMove(position);
+    }
 
-        currentTurn = (currentTurn == colorwhite) ? colorblack : colorwhite;
+    void undoMove()
+    {
+        if (moveHistory.empty())
+            return;
+
+        HistoryEntry entry = moveHistory.back();
+        moveHistory.pop();
+        redoHistory.push(entry);
+        position.unmake(entry.move, entry.undo);
+        currentTurn = position.sideToMove();
+        updateSprites(changedSquares(entry.move, currentTurn));
         gameState = stateplaying;
     }
 
+    void redoMove()
+    {
+        if (redoHistory.empty())
+            return;
+
+        Move move = redoHistory.back().move;
+        redoHistory.pop();
+        makeMove(move);
+    }
+
     void saveGameRecord()
     {
         ofstream file("game_records.txt", ios::app);
@@ -837,6 +621,14 @@ public:
                 {
                     file << blackPlayerName;
                 }
+                else if (gameState == statedrawrepetition)
+                {
+                    file << "Draw by threefold repetition";
+                }
+                else if (gameState == statedrawfiftymove)
+                {
+                    file << "Draw by fifty-move rule";
+                }
                 else
                 {
                     file << "Stalemate";
@@ -878,7 +670,25 @@ public:
             if (!keyPressed && event.key.code == sf::Keyboard::Z &&
                 sf::Keyboard::isKeyPressed(sf::Keyboard::LControl) && gameState == stateplaying)
             {
+                stopEngine();
                 undoMove();
+                if (currentTurn == computerColor)
+                    undoMove();
+                keyPressed = true;
+            }
+            if (!keyPressed && event.key.code == sf::Keyboard::Y &&
+                sf::Keyboard::isKeyPressed(sf::Keyboard::LControl) && gameState == stateplaying)
+            {
+                stopEngine();
+                redoMove();
+                if (currentTurn == computerColor)
+                    redoMove();
+                keyPressed = true;
+            }
+            if (!keyPressed && event.key.code == sf::Keyboard::H &&
+                sf::Keyboard::isKeyPressed(sf::Keyboard::LControl) && gameState == stateplaying)
+            {
+                showHanging = !showHanging;
                 keyPressed = true;
             }
             if (!keyPressed && event.key.code == sf::Keyboard::R &&
@@ -907,7 +717,8 @@ public:
         if (gameState != stateplaying)
             return;
 
-        if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left)
+        if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left &&
+            currentTurn != computerColor)
         {
             sf::Vector2f mousePos = window.mapPixelToCoords(sf::Mouse::getPosition(window));
 
@@ -933,206 +744,22 @@ public:
                 int col = (int)(mousePos.x / tilesize);
                 int row = (int)(mousePos.y / tilesize);
 
-                bool isValid = (col >= 0 && col < 8 && row >= 0 && row < 8);
-                bool isEnPassant = isValid && isValidEnPassant(selectedPiece, col, row);
-                bool isCastling = isValid && selectedPiece->getPieceType() == pieceking &&
-                                  abs(col - selectedPiece->getBoardX()) == 2 &&
-                                  row == selectedPiece->getBoardY();
-
-                if (isValid)
+                Move move = nomove;
+                if (col >= 0 && col < 8 && row >= 0 && row < 8)
                 {
-                    isValid = selectedPiece->isValidMove(col, row, pieceBoard) || isEnPassant;
+                    move = findLegalMove(selectedPiece->getBoardX(), selectedPiece->getBoardY(), col, row);
                 }
 
                 selectedPiece->getSprite().setPosition(
                     selectedPiece->getBoardX() * tilesize + tilesize / 4,
                     selectedPiece->getBoardY() * tilesize + tilesize / 4);
+                selectedPiece = nullptr;
 
-                int kingX = -1, kingY = -1;
-                bool moveAllowed = false;
-                if (isValid)
-                {
-                    moveAllowed = !wouldKingBeInCheck(selectedPiece, selectedPiece->getBoardX(),
-                                                      selectedPiece->getBoardY(), col, row,
-                                                      isEnPassant, isCastling);
-                }
-
-                if (isCastling && isValid && moveAllowed)
-                {
-                    int oldX = selectedPiece->getBoardX();
-                    int oldY = selectedPiece->getBoardY();
-                    bool inCheck = findKingPosition(currentTurn, kingX, kingY, pieceBoard) &&
-                                   isKingInCheck(currentTurn, kingX, kingY, pieceBoard);
-                    if (inCheck)
-                    {
-                        isValid = false;
-                        moveAllowed = false;
-                    }
-                    else if (col > oldX)
-                    {
-                        if (wouldKingBeInCheck(selectedPiece, oldX, oldY, oldX + 1, oldY, false, false) ||
-                            wouldKingBeInCheck(selectedPiece, oldX, oldY, oldX + 2, oldY, false, false))
-                        {
-                            isValid = false;
-                            moveAllowed = false;
-                        }
-                    }
-                    else
-                    {
-                        if (wouldKingBeInCheck(selectedPiece, oldX, oldY, oldX - 1, oldY, false, false) ||
-                            wouldKingBeInCheck(selectedPiece, oldX, oldY, oldX - 2, oldY, false, false))
-                        {
-                            isValid = false;
-                            moveAllowed = false;
-                        }
-                    }
-                }
-
-                if (moveAllowed && isValid && moveCount < moveCapacity)
+                if (move != nomove)
                 {
-                    int oldX = selectedPiece->getBoardX();
-                    int oldY = selectedPiece->getBoardY();
-                    int pieceIdx = -1;
-                    for (int i = 0; i < pieceCount; i++)
-                    {
-                        if (pieces[i] == selectedPiece)
-                        {
-                            pieceIdx = i;
-                            break;
-                        }
-                    }
-                    int capturedIdx = -1;
-                    int promotedIdx = -1;
-                    int originalPieceType = selectedPiece->getPieceType();
-                    int lastDoubleMovedPawnIdx = lastDoubleMovedPawn ? -1 : -1;
-                    for (int i = 0; i < pieceCount; i++)
-                    {
-                        if (lastDoubleMovedPawn && pieces[i] == lastDoubleMovedPawn)
-                        {
-                            lastDoubleMovedPawnIdx = i;
-                            break;
-                        }
-                    }
-
-                    int idx = moveCount * 16;
-                    moveHistory[idx] = pieceIdx;
-                    moveHistory[idx + 1] = oldX;
-                    moveHistory[idx + 2] = oldY;
-                    moveHistory[idx + 3] = col;
-                    moveHistory[idx + 4] = row;
-                    moveHistory[idx + 5] = -1;
-                    moveHistory[idx + 6] = isEnPassant ? 1 : 0;
-                    moveHistory[idx + 7] = isCastling ? 1 : 0;
-                    moveHistory[idx + 8] = 0;
-                    moveHistory[idx + 9] = 0;
-                    moveHistory[idx + 10] = selectedPiece->getHasMoved() ? 1 : 0;
-                    moveHistory[idx + 11] = 0;
-                    moveHistory[idx + 12] = originalPieceType;
-                    moveHistory[idx + 13] = -1;
-                    moveHistory[idx + 14] = lastDoubleMovedPawnIdx;
-                    moveHistory[idx + 15] = lastMoveTurn;
-
-                    if (isCastling)
-                    {
-                        int rookFromX = (col > oldX) ? 7 : 0;
-                        int rookToX = (col > oldX) ? 5 : 3;
-                        ChessPiece *rook = pieceBoard[rookFromX][oldY];
-                        if (rook)
-                        {
-                            moveHistory[idx + 8] = rookFromX;
-                            moveHistory[idx + 9] = rookToX;
-                            moveHistory[idx + 11] = rook->getHasMoved() ? 1 : 0;
-                            pieceBoard[rookFromX][oldY] = nullptr;
-                            pieceBoard[rookToX][oldY] = rook;
-                            rook->setPosition(rookToX * tilesize, oldY * tilesize);
-                            rook->setHasMoved(true);
-                        }
-                    }
-
-                    if (isEnPassant)
-                    {
-                        ChessPiece *captured = pieceBoard[col][oldY];
-                        if (captured)
-                        {
-                            capturedIdx = capturedPieces.size();
-                            capturedPieces.push_back(captured);
-                            moveHistory[idx + 5] = capturedIdx;
-                            for (int i = 0; i < pieceCount; i++)
-                            {
-                                if (pieces[i] == captured)
-                                {
-                                    pieces[i] = nullptr;
-                                    break;
-                                }
-                            }
-                            pieceBoard[col][oldY] = nullptr;
-                        }
-                    }
-                    else if (pieceBoard[col][row])
-                    {
-                        ChessPiece *captured = pieceBoard[col][row];
-                        capturedIdx = capturedPieces.size();
-                        capturedPieces.push_back(captured);
-                        moveHistory[idx + 5] = capturedIdx;
-                        for (int i = 0; i < pieceCount; i++)
-                        {
-                            if (pieces[i] == captured)
-                            {
-                                pieces[i] = nullptr;
-                                break;
-                            }
-                        }
-                        pieceBoard[col][row] = nullptr;
-                    }
-
-                    if (selectedPiece->getPieceType() == piecepawn && abs(row - oldY) == 2)
-                    {
-                        lastDoubleMovedPawn = selectedPiece;
-                        lastMoveTurn = currentTurn;
-                    }
-                    else
-                    {
-                        lastDoubleMovedPawn = nullptr;
-                    }
-
-                    pieceBoard[oldX][oldY] = nullptr;
-                    pieceBoard[col][row] = selectedPiece;
-                    selectedPiece->setPosition(col * tilesize, row * tilesize);
-                    selectedPiece->setHasMoved(true);
-
-                    if (selectedPiece->getPieceType() == piecepawn)
-                    {
-                        if ((selectedPiece->getColor() == colorwhite && row == 0) ||
-                            (selectedPiece->getColor() == colorblack && row == 7))
-                        {
-                            for (int i = 0; i < pieceCount; i++)
-                            {
-                                if (pieces[i] == selectedPiece)
-                                {
-                                    string texturePath = (selectedPiece->getColor() == colorwhite)
-                                                             ? "../textures/white_queen.png"
-                                                             : "../textures/black_queen.png";
-                                    ChessPiece *newQueen = new Queen(col * tilesize, row * tilesize,
-                                                                     texturePath, selectedPiece->getColor());
-                                    newQueen->setHasMoved(true);
-                                    capturedPieces.push_back(pieces[i]);
-                                    pieces[i] = newQueen;
-                                    promotedIdx = i;
-                                    moveHistory[idx + 13] = promotedIdx;
-                                    pieceBoard[col][row] = newQueen;
-                                    selectedPiece = newQueen;
-                                    break;
-                                }
-                            }
-                        }
-                    }
-
-                    moveCount++;
-                    currentTurn = (currentTurn == colorwhite) ? colorblack : colorwhite;
-                    checkGameState();
+                    redoHistory.clear();
+                    makeMove(move);
                 }
-
-                selectedPiece = nullptr;
             }
         }
 
@@ -1148,47 +775,30 @@ public:
 
     void checkGameState()
     {
-        if (!pieceBoard)
-            return;
-
-        bool whiteKingExists = false;
-        bool blackKingExists = false;
-
-        for (int i = 0; i < pieceCount; i++)
-        {
-            if (pieces[i] && pieces[i]->getPieceType() == pieceking)
-            {
-                if (pieces[i]->getColor() == colorwhite)
-                    whiteKingExists = true;
-                else
-                    blackKingExists = true;
-            }
-        }
-
-        if (!whiteKingExists)
+        if (!position.pieces(colorwhite, pieceking))
         {
             gameState = stateblackwon;
             saveGameRecord();
             return;
         }
-        if (!blackKingExists)
+        if (!position.pieces(colorblack, pieceking))
         {
             gameState = statewhitewon;
             saveGameRecord();
             return;
         }
 
-        int kingX = -1, kingY = -1;
-        if (!findKingPosition(currentTurn, kingX, kingY, pieceBoard))
-            return;
-
-        bool inCheck = isKingInCheck(currentTurn, kingX, kingY, pieceBoard);
+        bool inCheck = isKingInCheck(currentTurn);
         bool hasMoves = hasLegalMoves(currentTurn);
 
         if (inCheck && !hasMoves)
             gameState = (currentTurn == colorwhite) ? stateblackwon : statewhitewon;
         else if (!inCheck && !hasMoves)
             gameState = statestalemate;
+        else if (position.halfmoveClock() >= fiftymoveplies)
+            gameState = statedrawfiftymove;
+        else if (moveHistory.repetitions(position.hashKey(), position.halfmoveClock()) >= 2)
+            gameState = statedrawrepetition;
 
         if (gameState != stateplaying)
             saveGameRecord();
@@ -1227,6 +837,17 @@ public:
             window.draw(highlight);
         }
 
+        if (showHanging)
+        {
+            Bitboard hanging = hangingPieces(position, colorwhite) | hangingPieces(position, colorblack);
+            while (hanging)
+            {
+                int sq = popLsb(hanging);
+                hangingHighlight.setPosition(squareX(sq) * tilesize, squareY(sq) * tilesize);
+                window.draw(hangingHighlight);
+            }
+        }
+
         for (int i = 0; i < 8; i++)
         {
             for (int j = 0; j < 8; j++)
@@ -1256,6 +877,15 @@ public:
             window.draw(blackTimerText);
         }
 
+        if (computerColor != nocomputer && fontLoaded && engineInfo.depth > 0)
+        {
+            char engineBuffer[64];
+            snprintf(engineBuffer, sizeof(engineBuffer), "Depth %d  %.0f kN/s  %.2f s",
+                     engineInfo.depth, engineInfo.nps() / 1000, engineInfo.seconds);
+            engineText.setString(engineBuffer);
+            window.draw(engineText);
+        }
+
         if (gameState != stateplaying && gameState != staterecords && fontLoaded)
         {
             sf::Text text;
@@ -1271,6 +901,10 @@ public:
                 text.setString("Black Wins!");
             else if (gameState == statestalemate)
                 text.setString("Stalemate!");
+            else if (gameState == statedrawrepetition)
+                text.setString("Draw: Repetition!");
+            else if (gameState == statedrawfiftymove)
+                text.setString("Draw: 50 Moves!");
 
             window.draw(text);
         }
@@ -1278,6 +912,7 @@ public:
 
     ~ChessGame()
     {
+        stopEngine();
         delete board;
         for (int i = 0; i < pieceCount; i++)
         {
@@ -1293,7 +928,6 @@ public:
                 delete piece;
             }
         }
-        delete[] moveHistory;
         delete[] whitePlayerName;
         delete[] blackPlayerName;
     }
@@ -1301,6 +935,7 @@ public:
 
 int main()
 {
+    initAttacks();
     try
     {
         ChessGame game(true);
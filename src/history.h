@@ -0,0 +1,74 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include "position.h"
+#include <vector>
+
+// 24 bytes per ply: UndoInfo is the 8-byte position key plus 8 bytes of
+// state, and the 2-byte move is padded to the key's alignment.
+struct HistoryEntry
+{
+    Move move;
+    UndoInfo undo;
+};
+
+const int historychunk = 256;
+
+// Stack of played moves stored in fixed-size chunks. Growing never moves the
+// entries already stored, and chunks are kept after pops for reuse, so push and
+// pop are O(1) for any game length.
+class MoveHistory
+{
+    std::vector<HistoryEntry *> chunks;
+    int count;
+
+public:
+    MoveHistory() : count(0) {}
+    MoveHistory(const MoveHistory &) = delete;
+    MoveHistory &operator=(const MoveHistory &) = delete;
+
+    ~MoveHistory()
+    {
+        for (HistoryEntry *chunk : chunks)
+        {
+            delete[] chunk;
+        }
+    }
+
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+    void clear() { count = 0; }
+
+    HistoryEntry &push()
+    {
+        if (count == (int)chunks.size() * historychunk)
+        {
+            chunks.push_back(new HistoryEntry[historychunk]);
+        }
+        int index = count++;
+        return chunks[index / historychunk][index % historychunk];
+    }
+
+    void push(const HistoryEntry &entry) { push() = entry; }
+    void pop() { count--; }
+
+    HistoryEntry &operator[](int index) { return chunks[index / historychunk][index % historychunk]; }
+    const HistoryEntry &operator[](int index) const { return chunks[index / historychunk][index % historychunk]; }
+    HistoryEntry &back() { return (*this)[count - 1]; }
+
+    // Each entry keeps the key of the position it was played from, so the
+    // entries form a per-ply hash stack; this view indexes it as keys.
+    struct Keys
+    {
+        const MoveHistory &history;
+        Bitboard operator[](int index) const { return history[index].undo.key; }
+    };
+
+    // Earlier occurrences of key, by countRepetitions.
+    int repetitions(Bitboard key, int halfmoveClock) const
+    {
+        return countRepetitions(Keys{*this}, count, key, halfmoveClock, count);
+    }
+};
+
+#endif
@@ -0,0 +1,307 @@
+#include "movegen.h"
+#include "bitboard.h"
+using namespace std;
+
+const Bitboard topRow = 0xFFULL;
+const Bitboard bottomRow = 0xFFULL << 56;
+
+// Legality is settled up front: non-king moves must land in checkMask (the
+// checker and the squares between it and the king) and pinned pieces may only
+// move along the line through their king. King moves and en passant are the
+// only moves that still need an attack test.
+struct GenContext
+{
+    const Position &pos;
+    int us;
+    int them;
+    int king;
+    Bitboard own;
+    Bitboard enemies;
+    Bitboard occupied;
+    Bitboard checkers;
+    Bitboard checkMask;
+    Bitboard pinned;
+    int stages;
+    Bitboard targets;
+
+    GenContext(const Position &p, int s = genall)
+        : pos(p), us(p.sideToMove()), them(opponent(p.sideToMove())), king(p.kingSquare(p.sideToMove())),
+          own(p.pieces(p.sideToMove())), enemies(p.pieces(opponent(p.sideToMove()))), occupied(p.occupied()), stages(s)
+    {
+        targets = 0;
+        if (stages & gencaptures)
+            targets |= enemies;
+        if (stages & genquiets)
+            targets |= ~occupied;
+        checkers = p.checkers();
+        checkMask = checkers ? betweenBB(king, lsb(checkers)) | checkers : ~0ULL;
+        pinned = king != nosquare ? p.pinnedPieces(us) : 0;
+    }
+
+    bool pinAllows(int from, int to) const
+    {
+        return !(pinned & squareBit(from)) || (lineBB(king, from) & squareBit(to));
+    }
+};
+
+static void addPromotions(MoveList &list, int from, int to, bool capture)
+{
+    list.add(makeMove(from, to, promotionFlags(piecequeen, capture)));
+    list.add(makeMove(from, to, promotionFlags(pieceknight, capture)));
+    list.add(makeMove(from, to, promotionFlags(piecerook, capture)));
+    list.add(makeMove(from, to, promotionFlags(piecebishop, capture)));
+}
+
+static void generatePawnMoves(const GenContext &ctx, MoveList &list)
+{
+    int us = ctx.us;
+    Bitboard pawns = ctx.pos.pieces(us, piecepawn);
+    Bitboard empty = ~ctx.occupied;
+
+    int up = (us == colorwhite) ? -8 : 8;
+    Bitboard promotionRow = (us == colorwhite) ? topRow : bottomRow;
+    Bitboard doublePushRow = (us == colorwhite) ? 0xFFULL << 32 : 0xFFULL << 24;
+
+    Bitboard single = ((us == colorwhite) ? pawns >> 8 : pawns << 8) & empty;
+    Bitboard dbl = ((us == colorwhite) ? single >> 8 : single << 8) & empty & doublePushRow;
+    single &= ctx.checkMask;
+    dbl &= ctx.checkMask;
+    if (!(ctx.stages & gencaptures))
+        single &= ~promotionRow;
+    if (!(ctx.stages & genquiets))
+    {
+        single &= promotionRow;
+        dbl = 0;
+    }
+
+    while (single)
+    {
+        int to = popLsb(single);
+        if (!ctx.pinAllows(to - up, to))
+            continue;
+        if (squareBit(to) & promotionRow)
+            addPromotions(list, to - up, to, false);
+        else
+            list.add(makeMove(to - up, to, flagquiet));
+    }
+    while (dbl)
+    {
+        int to = popLsb(dbl);
+        if (ctx.pinAllows(to - 2 * up, to))
+            list.add(makeMove(to - 2 * up, to, flagdoublepush));
+    }
+
+    if (!(ctx.stages & gencaptures))
+        return;
+
+    Bitboard attackers = pawns;
+    while (attackers)
+    {
+        int from = popLsb(attackers);
+        Bitboard captures = pawnAttacks(us, from) & ctx.enemies & ctx.checkMask;
+        while (captures)
+        {
+            int to = popLsb(captures);
+            if (!ctx.pinAllows(from, to))
+                continue;
+            if (squareBit(to) & promotionRow)
+                addPromotions(list, from, to, true);
+            else
+                list.add(makeMove(from, to, flagcapture));
+        }
+    }
+
+    int ep = ctx.pos.enPassantSquare();
+    if (ep != nosquare)
+    {
+        Bitboard epAttackers = pawnAttacks(ctx.them, ep) & pawns;
+        while (epAttackers)
+        {
+            Move m = makeMove(popLsb(epAttackers), ep, flagenpassant);
+            if (isLegal(ctx.pos, m))
+                list.add(m);
+        }
+    }
+}
+
+static void generatePieceMoves(const GenContext &ctx, MoveList &list, int type)
+{
+    Bitboard pieces = ctx.pos.pieces(ctx.us, type);
+    while (pieces)
+    {
+        int from = popLsb(pieces);
+        Bitboard targets = pieceAttacks(ctx.us, type, from, ctx.occupied) & ctx.targets & ctx.checkMask;
+        if (ctx.pinned & squareBit(from))
+            targets &= lineBB(ctx.king, from);
+        while (targets)
+        {
+            int to = popLsb(targets);
+            list.add(makeMove(from, to, (squareBit(to) & ctx.enemies) ? flagcapture : flagquiet));
+        }
+    }
+}
+
+static void generateKingMoves(const GenContext &ctx, MoveList &list)
+{
+    if (ctx.king == nosquare)
+        return;
+    Bitboard targets = kingAttacks(ctx.king) & ctx.targets & ~ctx.pos.attackedBy(ctx.them);
+
+    // The attack map is built with the king on the board, so squares behind it
+    // on a checking slider's line still look safe.
+    Bitboard sliders = ctx.checkers & ~ctx.pos.pieces(ctx.them, piecepawn) & ~ctx.pos.pieces(ctx.them, pieceknight);
+    while (sliders)
+    {
+        int checker = popLsb(sliders);
+        targets &= ~lineBB(ctx.king, checker) | squareBit(checker);
+    }
+
+    while (targets)
+    {
+        int to = popLsb(targets);
+        list.add(makeMove(ctx.king, to, (squareBit(to) & ctx.enemies) ? flagcapture : flagquiet));
+    }
+}
+
+// The right implies king and rook are on their home squares.
+static bool canCastle(const Position &pos, bool kingside)
+{
+    int us = pos.sideToMove();
+    int them = opponent(us);
+    int right = kingside ? (us == colorwhite ? castlewhiteking : castleblackking)
+                         : (us == colorwhite ? castlewhitequeen : castleblackqueen);
+    if (!(pos.castlingRights() & right) || pos.checkers())
+        return false;
+
+    int king = pos.kingSquare(us);
+    if (kingside)
+        return !(pos.occupied() & (squareBit(king + 1) | squareBit(king + 2))) &&
+               !pos.isSquareAttacked(king + 1, them) && !pos.isSquareAttacked(king + 2, them);
+    return !(pos.occupied() & (squareBit(king - 1) | squareBit(king - 2) | squareBit(king - 3))) &&
+           !pos.isSquareAttacked(king - 1, them) && !pos.isSquareAttacked(king - 2, them);
+}
+
+static void generateCastling(const GenContext &ctx, MoveList &list)
+{
+    if (canCastle(ctx.pos, true))
+        list.add(makeMove(ctx.king, ctx.king + 2, flagkingcastle));
+    if (canCastle(ctx.pos, false))
+        list.add(makeMove(ctx.king, ctx.king - 2, flagqueencastle));
+}
+
+void generateLegalMoves(const Position &pos, MoveList &list, int stages)
+{
+    GenContext ctx(pos, stages);
+    generateKingMoves(ctx, list);
+    if (ctx.checkers & (ctx.checkers - 1))
+        return;
+
+    generatePawnMoves(ctx, list);
+    generatePieceMoves(ctx, list, pieceknight);
+    generatePieceMoves(ctx, list, piecebishop);
+    generatePieceMoves(ctx, list, piecerook);
+    generatePieceMoves(ctx, list, piecequeen);
+    if (stages & genquiets)
+        generateCastling(ctx, list);
+}
+
+bool isLegal(const Position &pos, Move m)
+{
+    return !pos.leavesKingAttacked(m);
+}
+
+bool isLegalMove(const Position &pos, Move m)
+{
+    if (m == nomove)
+        return false;
+    int us = pos.sideToMove();
+    int from = moveFrom(m);
+    int to = moveTo(m);
+    int flags = moveFlags(m);
+    int piece = pos.pieceAt(from);
+    if (flags > flagenpassant && !isPromotion(m))
+        return false;
+    if (piece == nopiece || colorOf(piece) != us || (pos.pieces(us) & squareBit(to)))
+        return false;
+
+    int type = typeOf(piece);
+    if (flags == flagenpassant)
+    {
+        if (type != piecepawn || to != pos.enPassantSquare() || !(pawnAttacks(us, from) & squareBit(to)))
+            return false;
+    }
+    else if (isCapture(m) != (pos.pieceAt(to) != nopiece))
+    {
+        return false;
+    }
+
+    if (type == piecepawn)
+    {
+        int up = (us == colorwhite) ? -8 : 8;
+        bool lastRow = squareY(to) == ((us == colorwhite) ? 0 : 7);
+        if (isCastling(m) || (flags != flagenpassant && isPromotion(m) != lastRow))
+            return false;
+        if (flags == flagdoublepush)
+        {
+            if (squareY(from) != ((us == colorwhite) ? 6 : 1) || to != from + 2 * up ||
+                (pos.occupied() & squareBit(from + up)))
+                return false;
+        }
+        else if (isCapture(m))
+        {
+            if (!(pawnAttacks(us, from) & squareBit(to)))
+                return false;
+        }
+        else if (to != from + up)
+        {
+            return false;
+        }
+    }
+    else
+    {
+        if (isPromotion(m) || flags == flagdoublepush || flags == flagenpassant)
+            return false;
+        if (isCastling(m))
+        {
+            bool kingside = flags == flagkingcastle;
+            return type == pieceking && to == from + (kingside ? 2 : -2) && canCastle(pos, kingside);
+        }
+        if (!(pieceAttacks(us, type, from, pos.occupied()) & squareBit(to)))
+            return false;
+    }
+    return isLegal(pos, m);
+}
+
+bool hasLegalMove(const Position &pos)
+{
+    GenContext ctx(pos);
+    MoveList list;
+    generateKingMoves(ctx, list);
+    if (list.size() || (ctx.checkers & (ctx.checkers - 1)))
+        return list.size() > 0;
+
+    // Castling is never the only move: it needs the square beside the king
+    // empty and safe, so a king move was already found.
+    generatePawnMoves(ctx, list);
+    if (list.size())
+        return true;
+    for (int type : {pieceknight, piecebishop, piecerook, piecequeen})
+    {
+        generatePieceMoves(ctx, list, type);
+        if (list.size())
+            return true;
+    }
+    return false;
+}
+
+string moveToString(Move m)
+{
+    string result;
+    result += (char)('a' + squareX(moveFrom(m)));
+    result += (char)('8' - squareY(moveFrom(m)));
+    result += (char)('a' + squareX(moveTo(m)));
+    result += (char)('8' - squareY(moveTo(m)));
+    if (isPromotion(m))
+        result += "prnbqk"[promotionType(m)];
+    return result;
+}
@@ -0,0 +1,39 @@
+#ifndef MOVEGEN_H
+#define MOVEGEN_H
+
+#include "position.h"
+#include <string>
+
+const int maxmovelist = 256;
+
+struct MoveList
+{
+    Move moves[maxmovelist];
+    int count;
+
+    MoveList() : count(0) {}
+
+    void add(Move m) { moves[count++] = m; }
+    int size() const { return count; }
+    Move operator[](int i) const { return moves[i]; }
+    const Move *begin() const { return moves; }
+    const Move *end() const { return moves + count; }
+};
+
+// Generation stages. Captures include en passant and every promotion, so
+// the two stages together produce exactly the legal moves.
+const int gencaptures = 1;
+const int genquiets = 2;
+const int genall = gencaptures | genquiets;
+
+void generateLegalMoves(const Position &pos, MoveList &list, int stages = genall);
+// isLegal() expects a move from the generator; isLegalMove() accepts any
+// 16-bit value, such as a move remembered from another position.
+bool isLegal(const Position &pos, Move m);
+bool isLegalMove(const Position &pos, Move m);
+bool hasLegalMove(const Position &pos);
+
+// Coordinate notation, e.g. "e2e4" or "e7e8q".
+std::string moveToString(Move m);
+
+#endif
@@ -0,0 +1,155 @@
+#include "movepick.h"
+#include <algorithm>
+using namespace std;
+
+const int stagettmove = 0;
+const int stagecapturesinit = 1;
+const int stagecaptures = 2;
+const int stagequietsinit = 3;
+const int stagequiets = 4;
+const int stagedeferred = 5;
+const int stagedone = 6;
+
+// Quiet ordering scores. History scores stay well below both bonuses.
+const int killerscore = 1 << 26;
+const int countermovescore = 1 << 25;
+
+// Piece ranks for MVV-LVA, indexed by piece type: most valuable victim
+// first, and among equal victims the least valuable attacker.
+inline constexpr int mvvLvaRank[piecetypes] = {1, 4, 2, 3, 5, 6};
+
+MovePicker::MovePicker(const Position &p, Move tableMove, const Move *killerMoves, Move counterMove,
+                       const int (*historyTable)[64])
+    : pos(p), ttMove(tableMove), counter(counterMove), history(historyTable), capturesOnly(false),
+      stage(stagettmove), index(0), deferredIndex(0), generated(0)
+{
+    killers[0] = killerMoves[0];
+    killers[1] = killerMoves[1];
+}
+
+MovePicker::MovePicker(const Position &p, const int (*historyTable)[64])
+    : pos(p), ttMove(nomove), counter(nomove), history(historyTable), capturesOnly(p.checkers() == 0),
+      stage(stagecapturesinit), index(0), deferredIndex(0), generated(0)
+{
+    killers[0] = nomove;
+    killers[1] = nomove;
+}
+
+void MovePicker::scoreCaptures()
+{
+    for (int i = 0; i < list.size(); i++)
+    {
+        Move m = list[i];
+        int victim = nopiece;
+        if (moveFlags(m) == flagenpassant)
+            victim = piecepawn;
+        else if (isCapture(m))
+            victim = typeOf(pos.pieceAt(moveTo(m)));
+        int attacker = typeOf(pos.pieceAt(moveFrom(m)));
+        scores[i] = (victim != nopiece ? mvvLvaRank[victim] * 8 : 0) - mvvLvaRank[attacker];
+        if (isPromotion(m))
+            scores[i] += mvvLvaRank[piecequeen] * 8;
+    }
+}
+
+void MovePicker::scoreQuiets()
+{
+    for (int i = 0; i < list.size(); i++)
+    {
+        Move m = list[i];
+        if (m == killers[0])
+            scores[i] = killerscore + 1;
+        else if (m == killers[1])
+            scores[i] = killerscore;
+        else if (m == counter)
+            scores[i] = countermovescore;
+        else
+            scores[i] = history[moveFrom(m)][moveTo(m)];
+    }
+}
+
+// One step of selection sort: brings the best remaining move to index and
+// returns it. Most nodes cut off after a move or two, so the rest is never
+// sorted.
+Move MovePicker::pickBest()
+{
+    int best = index;
+    for (int j = index + 1; j < list.size(); j++)
+    {
+        if (scores[j] > scores[best])
+            best = j;
+    }
+    swap(list.moves[index], list.moves[best]);
+    swap(scores[index], scores[best]);
+    return list.moves[index++];
+}
+
+Move MovePicker::next()
+{
+    switch (stage)
+    {
+    case stagettmove:
+        stage = stagecapturesinit;
+        // The table move may come from another position that shares the
+        // bucket, so it is checked before it is trusted.
+        if (isLegalMove(pos, ttMove))
+            return ttMove;
+        ttMove = nomove;
+        [[fallthrough]];
+
+    case stagecapturesinit:
+        generateLegalMoves(pos, list, gencaptures);
+        generated += list.size();
+        scoreCaptures();
+        index = 0;
+        stage = stagecaptures;
+        [[fallthrough]];
+
+    case stagecaptures:
+        while (index < list.size())
+        {
+            Move m = pickBest();
+            if (m == ttMove)
+                continue;
+            if (isPromotion(m) && promotionType(m) != piecequeen)
+                deferred.add(m);
+            else
+                return m;
+        }
+        if (capturesOnly)
+        {
+            stage = stagedone;
+            return nomove;
+        }
+        stage = stagequietsinit;
+        [[fallthrough]];
+
+    case stagequietsinit:
+        list.count = 0;
+        generateLegalMoves(pos, list, genquiets);
+        generated += list.size();
+        scoreQuiets();
+        index = 0;
+        stage = stagequiets;
+        [[fallthrough]];
+
+    case stagequiets:
+        while (index < list.size())
+        {
+            Move m = pickBest();
+            if (m != ttMove)
+                return m;
+        }
+        stage = stagedeferred;
+        [[fallthrough]];
+
+    case stagedeferred:
+        if (deferredIndex < deferred.size())
+            return deferred[deferredIndex++];
+        stage = stagedone;
+        [[fallthrough]];
+
+    default:
+        return nomove;
+    }
+}
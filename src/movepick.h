@@ -0,0 +1,48 @@
+#ifndef MOVEPICK_H
+#define MOVEPICK_H
+
+#include "movegen.h"
+
+// Hands out the legal moves of a position best first, generating as late as
+// possible: the table move is checked and returned before anything is
+// generated, captures and promotions come next, and quiet moves are only
+// generated once those are used up. Most cutoffs happen in the first two
+// stages, so many nodes never generate a quiet move.
+class MovePicker
+{
+    const Position &pos;
+    Move ttMove;
+    Move killers[2];
+    Move counter;
+    const int (*history)[64];
+
+    bool capturesOnly;
+    int stage;
+    MoveList list;
+    int scores[maxmovelist];
+    int index;
+    // Underpromotions, held back until after the quiet moves.
+    MoveList deferred;
+    int deferredIndex;
+    int generated;
+
+    void scoreCaptures();
+    void scoreQuiets();
+    Move pickBest();
+
+public:
+    // killerMoves points to the two killers for this ply; historyTable is
+    // indexed [from][to] for the side to move.
+    MovePicker(const Position &p, Move tableMove, const Move *killerMoves, Move counterMove,
+               const int (*historyTable)[64]);
+    // For quiescence: captures and queen promotions only, unless the side to
+    // move is in check, when every evasion is returned.
+    MovePicker(const Position &p, const int (*historyTable)[64]);
+
+    // The next move to try, or nomove when all have been returned.
+    Move next();
+    // Moves produced by the generator so far, for measuring its cost.
+    int generatedCount() const { return generated; }
+};
+
+#endif
@@ -0,0 +1,663 @@
+#include "nnue.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define NNUE_X86
+#endif
+using namespace std;
+
+// The accumulator rows, the activation and the first layer's dot products
+// are where evaluation spends its time; each instruction set has its own
+// version and the fastest the CPU supports is chosen at startup.
+struct Kernels
+{
+    // dst = src + each added row - each removed row, over nnuehidden values.
+    void (*update)(int16_t *dst, const int16_t *src, const int16_t *const *add, int addCount,
+                   const int16_t *const *sub, int subCount);
+    // Clipped ReLU of nnuehidden accumulator values into bytes.
+    void (*activate)(uint8_t *out, const int16_t *in);
+    // First dense layer: out[j] = bias[j] + the dot product of the
+    // 2 * nnuehidden activations with row j of the weights.
+    void (*affine)(int32_t *out, const uint8_t *in, const int8_t *weights, const int32_t *bias);
+};
+
+static void updateScalar(int16_t *dst, const int16_t *src, const int16_t *const *add, int addCount,
+                         const int16_t *const *sub, int subCount)
+{
+    for (int i = 0; i < nnuehidden; i++)
+    {
+        int value = src[i];
+        for (int a = 0; a < addCount; a++)
+            value += add[a][i];
+        for (int s = 0; s < subCount; s++)
+            value -= sub[s][i];
+        dst[i] = (int16_t)value;
+    }
+}
+
+static void activateScalar(uint8_t *out, const int16_t *in)
+{
+    for (int i = 0; i < nnuehidden; i++)
+        out[i] = (uint8_t)min(max((int)in[i], 0), nnueqa);
+}
+
+static void affineScalar(int32_t *out, const uint8_t *in, const int8_t *weights, const int32_t *bias)
+{
+    for (int j = 0; j < nnuel1; j++)
+    {
+        const int8_t *row = weights + j * 2 * nnuehidden;
+        int32_t sum = bias[j];
+        for (int i = 0; i < 2 * nnuehidden; i++)
+            sum += in[i] * row[i];
+        out[j] = sum;
+    }
+}
+
+#ifdef NNUE_X86
+__attribute__((target("sse4.1"))) static void updateSse(int16_t *dst, const int16_t *src, const int16_t *const *add,
+                                                        int addCount, const int16_t *const *sub, int subCount)
+{
+    for (int i = 0; i < nnuehidden; i += 8)
+    {
+        __m128i value = _mm_loadu_si128((const __m128i *)(src + i));
+        for (int a = 0; a < addCount; a++)
+            value = _mm_add_epi16(value, _mm_loadu_si128((const __m128i *)(add[a] + i)));
+        for (int s = 0; s < subCount; s++)
+            value = _mm_sub_epi16(value, _mm_loadu_si128((const __m128i *)(sub[s] + i)));
+        _mm_storeu_si128((__m128i *)(dst + i), value);
+    }
+}
+
+__attribute__((target("sse4.1"))) static void activateSse(uint8_t *out, const int16_t *in)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i top = _mm_set1_epi16(nnueqa);
+    for (int i = 0; i < nnuehidden; i += 16)
+    {
+        __m128i low = _mm_min_epi16(_mm_max_epi16(_mm_loadu_si128((const __m128i *)(in + i)), zero), top);
+        __m128i high = _mm_min_epi16(_mm_max_epi16(_mm_loadu_si128((const __m128i *)(in + i + 8)), zero), top);
+        _mm_storeu_si128((__m128i *)(out + i), _mm_packus_epi16(low, high));
+    }
+}
+
+// The dense layers take neurons four at a time: each load of the input
+// feeds four independent sums, and one horizontal reduction finishes all
+// four. maddubs multiplies unsigned activations by signed weights into
+// pairs of 16-bit sums, which can't saturate with activations at most 127;
+// madd by one widens them to 32 bits.
+__attribute__((target("sse4.1"))) static __m128i sumFour(__m128i a, __m128i b, __m128i c, __m128i d)
+{
+    a = _mm_add_epi32(_mm_unpacklo_epi32(a, b), _mm_unpackhi_epi32(a, b));
+    c = _mm_add_epi32(_mm_unpacklo_epi32(c, d), _mm_unpackhi_epi32(c, d));
+    return _mm_add_epi32(_mm_unpacklo_epi64(a, c), _mm_unpackhi_epi64(a, c));
+}
+
+__attribute__((target("sse4.1"))) static void affineSse(int32_t *out, const uint8_t *in, const int8_t *weights,
+                                                        const int32_t *bias)
+{
+    const __m128i ones = _mm_set1_epi16(1);
+    for (int j = 0; j < nnuel1; j += 4)
+    {
+        const int8_t *rows = weights + j * 2 * nnuehidden;
+        __m128i sums[4] = {_mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128()};
+        for (int i = 0; i < 2 * nnuehidden; i += 16)
+        {
+            __m128i x = _mm_loadu_si128((const __m128i *)(in + i));
+            for (int k = 0; k < 4; k++)
+            {
+                __m128i w = _mm_loadu_si128((const __m128i *)(rows + k * 2 * nnuehidden + i));
+                sums[k] = _mm_add_epi32(sums[k], _mm_madd_epi16(_mm_maddubs_epi16(x, w), ones));
+            }
+        }
+        __m128i total = sumFour(sums[0], sums[1], sums[2], sums[3]);
+        _mm_storeu_si128((__m128i *)(out + j),
+                         _mm_add_epi32(total, _mm_loadu_si128((const __m128i *)(bias + j))));
+    }
+}
+
+__attribute__((target("avx2"))) static void updateAvx2(int16_t *dst, const int16_t *src, const int16_t *const *add,
+                                                       int addCount, const int16_t *const *sub, int subCount)
+{
+    for (int i = 0; i < nnuehidden; i += 16)
+    {
+        __m256i value = _mm256_loadu_si256((const __m256i *)(src + i));
+        for (int a = 0; a < addCount; a++)
+            value = _mm256_add_epi16(value, _mm256_loadu_si256((const __m256i *)(add[a] + i)));
+        for (int s = 0; s < subCount; s++)
+            value = _mm256_sub_epi16(value, _mm256_loadu_si256((const __m256i *)(sub[s] + i)));
+        _mm256_storeu_si256((__m256i *)(dst + i), value);
+    }
+}
+
+// packus works within 128-bit lanes, so the 64-bit quarters are put back
+// in order afterwards.
+__attribute__((target("avx2"))) static void activateAvx2(uint8_t *out, const int16_t *in)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i top = _mm256_set1_epi16(nnueqa);
+    for (int i = 0; i < nnuehidden; i += 32)
+    {
+        __m256i low = _mm256_min_epi16(_mm256_max_epi16(_mm256_loadu_si256((const __m256i *)(in + i)), zero), top);
+        __m256i high =
+            _mm256_min_epi16(_mm256_max_epi16(_mm256_loadu_si256((const __m256i *)(in + i + 16)), zero), top);
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0xD8);
+        _mm256_storeu_si256((__m256i *)(out + i), packed);
+    }
+}
+
+__attribute__((target("avx2"))) static __m128i halves(__m256i v)
+{
+    return _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+}
+
+__attribute__((target("avx2"))) static void affineAvx2(int32_t *out, const uint8_t *in, const int8_t *weights,
+                                                       const int32_t *bias)
+{
+    const __m256i ones = _mm256_set1_epi16(1);
+    for (int j = 0; j < nnuel1; j += 4)
+    {
+        const int8_t *rows = weights + j * 2 * nnuehidden;
+        __m256i sums[4] = {_mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256(),
+                           _mm256_setzero_si256()};
+        for (int i = 0; i < 2 * nnuehidden; i += 32)
+        {
+            __m256i x = _mm256_loadu_si256((const __m256i *)(in + i));
+            for (int k = 0; k < 4; k++)
+            {
+                __m256i w = _mm256_loadu_si256((const __m256i *)(rows + k * 2 * nnuehidden + i));
+                sums[k] = _mm256_add_epi32(sums[k], _mm256_madd_epi16(_mm256_maddubs_epi16(x, w), ones));
+            }
+        }
+        __m128i total = sumFour(halves(sums[0]), halves(sums[1]), halves(sums[2]), halves(sums[3]));
+        _mm_storeu_si128((__m128i *)(out + j),
+                         _mm_add_epi32(total, _mm_loadu_si128((const __m128i *)(bias + j))));
+    }
+}
+
+__attribute__((target("avx512f,avx512bw"))) static void updateAvx512(int16_t *dst, const int16_t *src,
+                                                                     const int16_t *const *add, int addCount,
+                                                                     const int16_t *const *sub, int subCount)
+{
+    for (int i = 0; i < nnuehidden; i += 32)
+    {
+        __m512i value = _mm512_loadu_si512((const void *)(src + i));
+        for (int a = 0; a < addCount; a++)
+            value = _mm512_add_epi16(value, _mm512_loadu_si512((const void *)(add[a] + i)));
+        for (int s = 0; s < subCount; s++)
+            value = _mm512_sub_epi16(value, _mm512_loadu_si512((const void *)(sub[s] + i)));
+        _mm512_storeu_si512((void *)(dst + i), value);
+    }
+}
+
+__attribute__((target("avx512f,avx512bw"))) static void activateAvx512(uint8_t *out, const int16_t *in)
+{
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i top = _mm512_set1_epi16(nnueqa);
+    const __m512i order = _mm512_set_epi64(7, 5, 3, 1, 6, 4, 2, 0);
+    for (int i = 0; i < nnuehidden; i += 64)
+    {
+        __m512i low = _mm512_min_epi16(_mm512_max_epi16(_mm512_loadu_si512((const void *)(in + i)), zero), top);
+        __m512i high =
+            _mm512_min_epi16(_mm512_max_epi16(_mm512_loadu_si512((const void *)(in + i + 32)), zero), top);
+        __m512i packed = _mm512_permutexvar_epi64(order, _mm512_packus_epi16(low, high));
+        _mm512_storeu_si512((void *)(out + i), packed);
+    }
+}
+
+__attribute__((target("avx512f,avx512bw"))) static __m128i quarters(__m512i v)
+{
+    __m256i half = _mm256_add_epi32(_mm512_castsi512_si256(v), _mm512_extracti64x4_epi64(v, 1));
+    return _mm_add_epi32(_mm256_castsi256_si128(half), _mm256_extracti128_si256(half, 1));
+}
+
+__attribute__((target("avx512f,avx512bw"))) static void affineAvx512(int32_t *out, const uint8_t *in,
+                                                                     const int8_t *weights, const int32_t *bias)
+{
+    const __m512i ones = _mm512_set1_epi16(1);
+    for (int j = 0; j < nnuel1; j += 4)
+    {
+        const int8_t *rows = weights + j * 2 * nnuehidden;
+        __m512i sums[4] = {_mm512_setzero_si512(), _mm512_setzero_si512(), _mm512_setzero_si512(),
+                           _mm512_setzero_si512()};
+        for (int i = 0; i < 2 * nnuehidden; i += 64)
+        {
+            __m512i x = _mm512_loadu_si512((const void *)(in + i));
+            for (int k = 0; k < 4; k++)
+            {
+                __m512i w = _mm512_loadu_si512((const void *)(rows + k * 2 * nnuehidden + i));
+                sums[k] = _mm512_add_epi32(sums[k], _mm512_madd_epi16(_mm512_maddubs_epi16(x, w), ones));
+            }
+        }
+        __m128i total = sumFour(quarters(sums[0]), quarters(sums[1]), quarters(sums[2]), quarters(sums[3]));
+        _mm_storeu_si128((__m128i *)(out + j),
+                         _mm_add_epi32(total, _mm_loadu_si128((const __m128i *)(bias + j))));
+    }
+}
+#endif
+
+static Kernels kernels = {updateScalar, activateScalar, affineScalar};
+
+int cpuSimdLevel()
+{
+#ifdef NNUE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+        return simdavx512;
+    if (__builtin_cpu_supports("avx2"))
+        return simdavx2;
+    if (__builtin_cpu_supports("sse4.1"))
+        return simdsse41;
+#endif
+    return simdscalar;
+}
+
+static int simdLevel = selectSimd(cpuSimdLevel());
+
+int selectSimd(int level)
+{
+    level = min(level, cpuSimdLevel());
+    kernels = {updateScalar, activateScalar, affineScalar};
+#ifdef NNUE_X86
+    if (level == simdsse41)
+        kernels = {updateSse, activateSse, affineSse};
+    else if (level == simdavx2)
+        kernels = {updateAvx2, activateAvx2, affineAvx2};
+    else if (level == simdavx512)
+        kernels = {updateAvx512, activateAvx512, affineAvx512};
+#endif
+    simdLevel = level;
+    return level;
+}
+
+int activeSimd()
+{
+    return simdLevel;
+}
+
+const char *simdName(int level)
+{
+    static const char *names[] = {"scalar", "sse4.1", "avx2", "avx512"};
+    return names[level];
+}
+
+struct NetworkHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t inputs;
+    uint32_t hidden;
+    uint32_t l1;
+};
+
+const char networkmagic[4] = {'N', 'N', 'U', 'E'};
+const uint32_t networkversion = 1;
+
+static size_t padded(size_t bytes)
+{
+    return (bytes + 63) & ~(size_t)63;
+}
+
+// Byte offsets of each section in the file.
+struct NetworkLayout
+{
+    size_t featureBias;
+    size_t featureWeights;
+    size_t l1Bias;
+    size_t l1Weights;
+    size_t outputBias;
+    size_t outputWeights;
+    size_t total;
+};
+
+static NetworkLayout networkLayout()
+{
+    NetworkLayout layout;
+    size_t offset = padded(sizeof(NetworkHeader));
+    layout.featureBias = offset;
+    offset += padded(nnuehidden * sizeof(int16_t));
+    layout.featureWeights = offset;
+    offset += padded((size_t)nnueinputs * nnuehidden * sizeof(int16_t));
+    layout.l1Bias = offset;
+    offset += padded(nnuel1 * sizeof(int32_t));
+    layout.l1Weights = offset;
+    offset += padded(nnuel1 * 2 * nnuehidden * sizeof(int8_t));
+    layout.outputBias = offset;
+    offset += padded(sizeof(int32_t));
+    layout.outputWeights = offset;
+    offset += padded(nnuel1 * sizeof(int8_t));
+    layout.total = offset;
+    return layout;
+}
+
+Network::Network()
+    : featureBias(nullptr), featureWeights(nullptr), l1Bias(nullptr), l1Weights(nullptr), outputBias(nullptr),
+      outputWeights(nullptr), owned(nullptr), mapped(nullptr), mappedBytes(0)
+#ifdef _WIN32
+      ,
+      fileHandle(nullptr), mappingHandle(nullptr)
+#endif
+{
+}
+
+Network::~Network()
+{
+    release();
+}
+
+void Network::release()
+{
+    if (owned)
+        ::operator delete(owned, align_val_t(64));
+    owned = nullptr;
+#ifdef _WIN32
+    if (mapped)
+        UnmapViewOfFile(mapped);
+    if (mappingHandle)
+        CloseHandle(mappingHandle);
+    if (fileHandle)
+        CloseHandle(fileHandle);
+    fileHandle = mappingHandle = nullptr;
+#else
+    if (mapped)
+        munmap((void *)mapped, mappedBytes);
+#endif
+    mapped = nullptr;
+    mappedBytes = 0;
+    featureBias = featureWeights = nullptr;
+    l1Bias = outputBias = nullptr;
+    l1Weights = outputWeights = nullptr;
+}
+
+bool Network::attach(const char *data, size_t bytes)
+{
+    NetworkLayout layout = networkLayout();
+    NetworkHeader header;
+    if (bytes < layout.total)
+        return false;
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, networkmagic, sizeof(networkmagic)) != 0 || header.version != networkversion ||
+        header.inputs != nnueinputs || header.hidden != nnuehidden || header.l1 != nnuel1)
+        return false;
+
+    featureBias = (const int16_t *)(data + layout.featureBias);
+    featureWeights = (const int16_t *)(data + layout.featureWeights);
+    l1Bias = (const int32_t *)(data + layout.l1Bias);
+    l1Weights = (const int8_t *)(data + layout.l1Weights);
+    outputBias = (const int32_t *)(data + layout.outputBias);
+    outputWeights = (const int8_t *)(data + layout.outputWeights);
+    return true;
+}
+
+// Mapped rather than read: the pages are shared with any other process
+// using the same file and only those touched are loaded.
+bool Network::load(const string &path)
+{
+    release();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER size;
+    HANDLE mapping = nullptr;
+    if (GetFileSizeEx(file, &size))
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const void *view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    fileHandle = file;
+    mappingHandle = mapping;
+    if (!view)
+    {
+        release();
+        return false;
+    }
+    mapped = view;
+    mappedBytes = (size_t)size.QuadPart;
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    void *view = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+        view = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED)
+        return false;
+    mapped = view;
+    mappedBytes = (size_t)st.st_size;
+#endif
+    if (!attach((const char *)mapped, mappedBytes))
+    {
+        release();
+        return false;
+    }
+    return true;
+}
+
+bool Network::save(const string &path) const
+{
+    if (!loaded())
+        return false;
+    FILE *file = fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+
+    NetworkLayout layout = networkLayout();
+    NetworkHeader header = {{'N', 'N', 'U', 'E'}, networkversion, nnueinputs, nnuehidden, nnuel1};
+    const void *sections[] = {&header,   featureBias, featureWeights, l1Bias,
+                              l1Weights, outputBias,  outputWeights};
+    size_t offsets[] = {0,
+                        layout.featureBias,
+                        layout.featureWeights,
+                        layout.l1Bias,
+                        layout.l1Weights,
+                        layout.outputBias,
+                        layout.outputWeights,
+                        layout.total};
+    size_t sizes[] = {sizeof(header),
+                      nnuehidden * sizeof(int16_t),
+                      (size_t)nnueinputs * nnuehidden * sizeof(int16_t),
+                      nnuel1 * sizeof(int32_t),
+                      nnuel1 * 2 * nnuehidden * sizeof(int8_t),
+                      sizeof(int32_t),
+                      nnuel1 * sizeof(int8_t)};
+    bool ok = true;
+    static const char zeros[64] = {};
+    for (int i = 0; i < 7 && ok; i++)
+    {
+        ok = fwrite(sections[i], 1, sizes[i], file) == sizes[i];
+        size_t padding = offsets[i + 1] - offsets[i] - sizes[i];
+        ok = ok && fwrite(zeros, 1, padding, file) == padding;
+    }
+    return fclose(file) == 0 && ok;
+}
+
+static uint64_t nextRandom(uint64_t &state)
+{
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 2685821657736338717ULL;
+}
+
+// Uniform in [low, high].
+static int randomBetween(uint64_t &state, int low, int high)
+{
+    return low + (int)(nextRandom(state) % (uint64_t)(high - low + 1));
+}
+
+// Random weights in ranges that keep most activations inside the clipped
+// ReLU, so the kernels do realistic work. The scores mean nothing.
+void Network::randomize(uint64_t seed)
+{
+    release();
+    NetworkLayout layout = networkLayout();
+    char *data = (char *)::operator new(layout.total, align_val_t(64));
+    memset(data, 0, layout.total);
+    owned = data;
+
+    NetworkHeader header = {{'N', 'N', 'U', 'E'}, networkversion, nnueinputs, nnuehidden, nnuel1};
+    memcpy(data, &header, sizeof(header));
+    uint64_t state = seed | 1;
+    int16_t *bias = (int16_t *)(data + layout.featureBias);
+    for (int i = 0; i < nnuehidden; i++)
+        bias[i] = (int16_t)randomBetween(state, 0, 63);
+    int16_t *weights = (int16_t *)(data + layout.featureWeights);
+    for (int i = 0; i < nnueinputs * nnuehidden; i++)
+        weights[i] = (int16_t)randomBetween(state, -8, 8);
+    int32_t *hiddenBias = (int32_t *)(data + layout.l1Bias);
+    for (int i = 0; i < nnuel1; i++)
+        hiddenBias[i] = randomBetween(state, -2048, 2048);
+    int8_t *hiddenWeights = (int8_t *)(data + layout.l1Weights);
+    for (int i = 0; i < nnuel1 * 2 * nnuehidden; i++)
+        hiddenWeights[i] = (int8_t)randomBetween(state, -16, 16);
+    *(int32_t *)(data + layout.outputBias) = 0;
+    int8_t *output = (int8_t *)(data + layout.outputWeights);
+    for (int i = 0; i < nnuel1; i++)
+        output[i] = (int8_t)randomBetween(state, -32, 32);
+    attach(data, layout.total);
+}
+
+const int16_t *Network::featureRow(int perspective, int piece, int sq) const
+{
+    int relative = colorOf(piece) == perspective ? 0 : piecetypes;
+    int square = perspective == colorwhite ? sq : sq ^ 56;
+    return featureWeights + ((relative + typeOf(piece)) * 64 + square) * nnuehidden;
+}
+
+void Network::refresh(const Position &pos, int perspective, int16_t *accumulator) const
+{
+    const int16_t *rows[32];
+    int count = 0;
+    Bitboard occupied = pos.occupied();
+    while (occupied)
+    {
+        int sq = popLsb(occupied);
+        rows[count++] = featureRow(perspective, pos.pieceAt(sq), sq);
+    }
+    kernels.update(accumulator, featureBias, rows, count, nullptr, 0);
+}
+
+int Network::propagate(const int16_t *us, const int16_t *them) const
+{
+    alignas(64) uint8_t input[2 * nnuehidden];
+    kernels.activate(input, us);
+    kernels.activate(input + nnuehidden, them);
+    int32_t hidden[nnuel1];
+    kernels.affine(hidden, input, l1Weights, l1Bias);
+    int32_t output = outputBias[0];
+    for (int j = 0; j < nnuel1; j++)
+        output += min(max(hidden[j] / nnueqb, 0), nnueqa) * outputWeights[j];
+    return (int)((int64_t)output * nnuescale / (nnueqa * nnueqb));
+}
+
+int Network::evaluate(const Position &pos) const
+{
+    alignas(64) int16_t accumulators[2][nnuehidden];
+    refresh(pos, colorwhite, accumulators[colorwhite]);
+    refresh(pos, colorblack, accumulators[colorblack]);
+    int us = pos.sideToMove();
+    return propagate(accumulators[us], accumulators[opponent(us)]);
+}
+
+void AccumulatorStack::reset(const Network &net, const Position &pos)
+{
+    top = 0;
+    net.refresh(pos, colorwhite, entries[0].values[colorwhite]);
+    net.refresh(pos, colorblack, entries[0].values[colorblack]);
+    entries[0].computed = true;
+}
+
+void AccumulatorStack::push(const Position &pos, Move m)
+{
+    Accumulator &next = entries[++top];
+    next.computed = false;
+    int us = pos.sideToMove();
+    int from = moveFrom(m);
+    int to = moveTo(m);
+    int piece = pos.pieceAt(from);
+    int placed = isPromotion(m) ? makePiece(us, promotionType(m)) : piece;
+    next.removed[0][0] = piece;
+    next.removed[0][1] = from;
+    next.added[0][0] = placed;
+    next.added[0][1] = to;
+    next.removedCount = 1;
+    next.addedCount = 1;
+
+    int rook = makePiece(us, piecerook);
+    if (moveFlags(m) == flagenpassant)
+    {
+        next.removed[1][0] = makePiece(opponent(us), piecepawn);
+        next.removed[1][1] = (us == colorwhite) ? to + 8 : to - 8;
+        next.removedCount = 2;
+    }
+    else if (isCapture(m))
+    {
+        next.removed[1][0] = pos.pieceAt(to);
+        next.removed[1][1] = to;
+        next.removedCount = 2;
+    }
+    else if (isCastling(m))
+    {
+        bool kingside = moveFlags(m) == flagkingcastle;
+        next.removed[1][0] = rook;
+        next.removed[1][1] = kingside ? to + 1 : to - 2;
+        next.added[1][0] = rook;
+        next.added[1][1] = kingside ? to - 1 : to + 1;
+        next.removedCount = 2;
+        next.addedCount = 2;
+    }
+}
+
+void AccumulatorStack::pushNull()
+{
+    Accumulator &next = entries[++top];
+    next.computed = false;
+    next.removedCount = 0;
+    next.addedCount = 0;
+}
+
+int AccumulatorStack::evaluate(const Network &net, const Position &pos)
+{
+    int first = top;
+    while (!entries[first].computed)
+        first--;
+    for (int i = first + 1; i <= top; i++)
+    {
+        const Accumulator &parent = entries[i - 1];
+        Accumulator &entry = entries[i];
+        for (int perspective = 0; perspective < 2; perspective++)
+        {
+            const int16_t *add[2];
+            const int16_t *sub[2];
+            for (int a = 0; a < entry.addedCount; a++)
+                add[a] = net.featureRow(perspective, entry.added[a][0], entry.added[a][1]);
+            for (int s = 0; s < entry.removedCount; s++)
+                sub[s] = net.featureRow(perspective, entry.removed[s][0], entry.removed[s][1]);
+            kernels.update(entry.values[perspective], parent.values[perspective], add, entry.addedCount, sub,
+                           entry.removedCount);
+        }
+        entry.computed = true;
+    }
+
+    int us = pos.sideToMove();
+    int score = net.propagate(entries[top].values[us], entries[top].values[opponent(us)]);
+#ifdef HASHCHECK
+    if (score != net.evaluate(pos))
+        throw runtime_error("NNUE accumulator out of sync with the board");
+#endif
+    return score;
+}
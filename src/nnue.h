@@ -0,0 +1,114 @@
+#ifndef NNUE_H
+#define NNUE_H
+
+#include "position.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Network shape: each perspective sees 768 inputs (own and enemy piece type
+// by square, mirrored for black) feeding a 256-wide accumulator. The two
+// accumulators, side to move first, pass through a clipped ReLU into 32
+// hidden neurons and then a single output.
+const int nnueinputs = 2 * piecetypes * 64;
+const int nnuehidden = 256;
+const int nnuel1 = 32;
+
+// Quantization: activations are clipped to [0, nnueqa], layer weights carry
+// a factor of nnueqb, and the output is scaled to centipawns by nnuescale.
+const int nnueqa = 127;
+const int nnueqb = 64;
+const int nnuescale = 400;
+
+// Instruction sets for the vector kernels, slowest first.
+const int simdscalar = 0;
+const int simdsse41 = 1;
+const int simdavx2 = 2;
+const int simdavx512 = 3;
+
+int cpuSimdLevel();
+// Switches the kernels to level, lowered to what the CPU supports, and
+// returns the level in use. The best level is selected at startup.
+int selectSimd(int level);
+int activeSimd();
+const char *simdName(int level);
+
+// Weights either mapped read-only from a file or, for benchmarks and tests
+// without a trained network, generated in memory. The file is the header
+// followed by each array in the order of the members below, every section
+// padded to 64 bytes and all values little-endian.
+class Network
+{
+    const int16_t *featureBias;
+    const int16_t *featureWeights;
+    const int32_t *l1Bias;
+    const int8_t *l1Weights;
+    const int32_t *outputBias;
+    const int8_t *outputWeights;
+
+    void *owned;
+    const void *mapped;
+    size_t mappedBytes;
+#ifdef _WIN32
+    void *fileHandle;
+    void *mappingHandle;
+#endif
+
+    void release();
+    bool attach(const char *data, size_t bytes);
+
+public:
+    Network();
+    ~Network();
+    Network(const Network &) = delete;
+    Network &operator=(const Network &) = delete;
+
+    bool load(const std::string &path);
+    bool save(const std::string &path) const;
+    void randomize(uint64_t seed);
+    bool loaded() const { return featureWeights != nullptr; }
+
+    const int16_t *featureRow(int perspective, int piece, int sq) const;
+    // Bias plus the rows of every piece on the board.
+    void refresh(const Position &pos, int perspective, int16_t *accumulator) const;
+    // Output for the side owning us, from both finished accumulators.
+    int propagate(const int16_t *us, const int16_t *them) const;
+    // From scratch, without an accumulator stack.
+    int evaluate(const Position &pos) const;
+};
+
+// One ply of the accumulator stack. An entry holds the features the move
+// into it changed and is brought up to date from its parent only when a
+// position below it is evaluated.
+struct alignas(64) Accumulator
+{
+    int16_t values[2][nnuehidden];
+    bool computed;
+    int addedCount;
+    int removedCount;
+    // (piece, square) pairs.
+    int added[2][2];
+    int removed[2][2];
+};
+
+// Deeper than any line the search follows, null moves included.
+const int accumulatorstacksize = 256;
+
+// Per-thread accumulators, pushed before make and popped after unmake.
+class AccumulatorStack
+{
+    Accumulator entries[accumulatorstacksize];
+    int top;
+
+public:
+    AccumulatorStack() : top(0) { entries[0].computed = false; }
+
+    void reset(const Network &net, const Position &pos);
+    // pos is the position before m is made.
+    void push(const Position &pos, Move m);
+    void pushNull();
+    void pop() { top--; }
+    int evaluate(const Network &net, const Position &pos);
+};
+
+#endif
@@ -0,0 +1,189 @@
+#include "pawns.h"
+#include "bitboard.h"
+#include <algorithm>
+#include <stdexcept>
+using namespace std;
+
+const int doubledmg = 10;
+const int doubledeg = 25;
+const int isolatedmg = 5;
+const int isolatedeg = 15;
+const int backwardmg = 9;
+const int backwardeg = 24;
+
+// By rank counted from the pawn's own side, so index 6 is one step from
+// promoting.
+inline constexpr int passedMg[8] = {0, 2, 5, 8, 15, 25, 40, 0};
+inline constexpr int passedEg[8] = {0, 5, 10, 18, 30, 50, 80, 0};
+
+// Per file beside and in front of the king: a pawn one or two squares ahead
+// of the back rank, or none at all.
+const int shieldclose = 12;
+const int shieldfar = 6;
+const int shieldmissing = -12;
+
+struct PawnMasks
+{
+    // Squares ahead on the pawn's file and on the files beside it.
+    Bitboard passed[2][64];
+    // Squares ahead on the pawn's file.
+    Bitboard front[2][64];
+    // Squares on the files beside the pawn, level with it or behind.
+    Bitboard support[2][64];
+    Bitboard adjacentFiles[8];
+};
+
+constexpr PawnMasks makePawnMasks()
+{
+    PawnMasks masks{};
+    for (int x = 0; x < 8; x++)
+    {
+        if (x > 0)
+            masks.adjacentFiles[x] |= fileA << (x - 1);
+        if (x < 7)
+            masks.adjacentFiles[x] |= fileA << (x + 1);
+    }
+    for (int sq = 0; sq < 64; sq++)
+    {
+        int x = squareX(sq);
+        int y = squareY(sq);
+        for (int other = 0; other < 64; other++)
+        {
+            int ox = squareX(other);
+            int oy = squareY(other);
+            Bitboard bit = squareBit(other);
+            bool near = ox >= x - 1 && ox <= x + 1;
+            // White pawns advance towards y = 0.
+            if (near && oy < y)
+                masks.passed[colorwhite][sq] |= bit;
+            if (near && oy > y)
+                masks.passed[colorblack][sq] |= bit;
+            if (ox == x && oy < y)
+                masks.front[colorwhite][sq] |= bit;
+            if (ox == x && oy > y)
+                masks.front[colorblack][sq] |= bit;
+            if (near && ox != x && oy >= y)
+                masks.support[colorwhite][sq] |= bit;
+            if (near && ox != x && oy <= y)
+                masks.support[colorblack][sq] |= bit;
+        }
+    }
+    return masks;
+}
+
+inline constexpr PawnMasks pawnMasks = makePawnMasks();
+
+static int relativeRank(int color, int sq)
+{
+    return color == colorwhite ? 7 - squareY(sq) : squareY(sq);
+}
+
+static int shieldScore(Bitboard ours, int color, int file)
+{
+    int closeY = color == colorwhite ? 6 : 1;
+    int farY = color == colorwhite ? 5 : 2;
+    int score = 0;
+    for (int x = max(file - 1, 0); x <= min(file + 1, 7); x++)
+    {
+        if (ours & squareBit(makeSquare(x, closeY)))
+            score += shieldclose;
+        else if (ours & squareBit(makeSquare(x, farY)))
+            score += shieldfar;
+        else
+            score += shieldmissing;
+    }
+    return score;
+}
+
+void evaluatePawns(const Position &pos, PawnEntry &entry)
+{
+    entry.key = pos.pawnHashKey();
+    entry.mgScore = 0;
+    entry.egScore = 0;
+    for (int color = colorwhite; color <= colorblack; color++)
+    {
+        int them = opponent(color);
+        int sign = color == colorwhite ? 1 : -1;
+        Bitboard ours = pos.pieces(color, piecepawn);
+        Bitboard theirs = pos.pieces(them, piecepawn);
+        Bitboard theirAttacks = pawnSetAttacks(them, theirs);
+        int mg = 0;
+        int eg = 0;
+        entry.passed[color] = 0;
+
+        Bitboard pawns = ours;
+        while (pawns)
+        {
+            int sq = popLsb(pawns);
+            int stop = color == colorwhite ? sq - 8 : sq + 8;
+            // Only the rearmost of a file's pawns counts as doubled, and
+            // only the frontmost can be passed.
+            bool doubled = pawnMasks.front[color][sq] & ours;
+            bool isolated = !(pawnMasks.adjacentFiles[squareX(sq)] & ours);
+            bool backward =
+                !isolated && !(pawnMasks.support[color][sq] & ours) && (theirAttacks & squareBit(stop));
+            if (doubled)
+            {
+                mg -= doubledmg;
+                eg -= doubledeg;
+            }
+            if (isolated)
+            {
+                mg -= isolatedmg;
+                eg -= isolatedeg;
+            }
+            else if (backward)
+            {
+                mg -= backwardmg;
+                eg -= backwardeg;
+            }
+            if (!doubled && !(pawnMasks.passed[color][sq] & theirs))
+            {
+                entry.passed[color] |= squareBit(sq);
+                mg += passedMg[relativeRank(color, sq)];
+                eg += passedEg[relativeRank(color, sq)];
+            }
+        }
+        entry.mgScore += sign * mg;
+        entry.egScore += sign * eg;
+        for (int file = 0; file < 8; file++)
+            entry.shield[color][file] = shieldScore(ours, color, file);
+    }
+}
+
+PawnHashTable::PawnHashTable() : entries(pawnhashentries), counters()
+{
+    clear();
+}
+
+// Every slot starts as the entry for no pawns at all, whose key is zero, so
+// an empty slot can never be mistaken for another structure.
+void PawnHashTable::clear()
+{
+    PawnEntry empty;
+    evaluatePawns(Position(), empty);
+    for (PawnEntry &entry : entries)
+        entry = empty;
+}
+
+const PawnEntry &PawnHashTable::probe(const Position &pos)
+{
+    Bitboard key = pos.pawnHashKey();
+    PawnEntry &entry = entries[key & (entries.size() - 1)];
+    counters.probes++;
+    if (entry.key == key)
+    {
+        counters.hits++;
+#ifdef HASHCHECK
+        PawnEntry fresh;
+        evaluatePawns(pos, fresh);
+        if (fresh.mgScore != entry.mgScore || fresh.egScore != entry.egScore ||
+            fresh.passed[colorwhite] != entry.passed[colorwhite] ||
+            fresh.passed[colorblack] != entry.passed[colorblack])
+            throw runtime_error("pawn hash entry does not match the pawns");
+#endif
+        return entry;
+    }
+    evaluatePawns(pos, entry);
+    return entry;
+}
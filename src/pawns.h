@@ -0,0 +1,51 @@
+#ifndef PAWNS_H
+#define PAWNS_H
+
+#include "position.h"
+#include <vector>
+
+// Pawn-structure terms from white's side. They depend on nothing but the
+// pawns, so they are computed once per pawn key and cached.
+struct PawnEntry
+{
+    Bitboard key;
+    int mgScore;
+    int egScore;
+    Bitboard passed[2];
+    // Middle-game bonus, indexed by colour and file, for a king on its first
+    // two ranks from the pawns in front of it.
+    int shield[2][8];
+};
+
+// Doubled, isolated, backward and passed pawns and the king shields.
+void evaluatePawns(const Position &pos, PawnEntry &entry);
+
+struct PawnHashStats
+{
+    unsigned long long probes;
+    unsigned long long hits;
+
+    double hitRate() const { return probes ? (double)hits / probes : 0; }
+};
+
+// 16K entries, about 1.5 MB.
+const int pawnhashentries = 1 << 14;
+
+// One per search thread, so it needs no locking. Entries never go stale:
+// one is only replaced by another pawn structure hashing to its slot.
+class PawnHashTable
+{
+    std::vector<PawnEntry> entries;
+    PawnHashStats counters;
+
+public:
+    PawnHashTable();
+
+    // The entry for pos's pawns, computed on a miss.
+    const PawnEntry &probe(const Position &pos);
+    void clear();
+    const PawnHashStats &stats() const { return counters; }
+    void resetStats() { counters = PawnHashStats(); }
+};
+
+#endif
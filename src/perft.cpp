@@ -0,0 +1,438 @@
+#include "bitboard.h"
+#include "movegen.h"
+#include "position.h"
+#include "reference.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+typedef void (*Generator)(const Position &pos, MoveList &list);
+
+static void generateAll(const Position &pos, MoveList &list)
+{
+    generateLegalMoves(pos, list);
+}
+
+const int maxperftdepth = 7;
+
+struct PerftCase
+{
+    const char *name;
+    const char *fen;
+    int depth;
+    unsigned long long nodes[maxperftdepth];
+};
+
+// Published node counts; nodes[d - 1] is the count at depth d. The last group
+// are small positions built around en passant, castling and promotion rules.
+static const PerftCase suite[] = {
+    {"initial position", startfen, 5, {20, 400, 8902, 197281, 4865609}},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4, {48, 2039, 97862, 4085603}},
+    {"rook endgame", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 5, {14, 191, 2812, 43238, 674624}},
+    {"promotions", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 4, {6, 264, 9467, 422333}},
+    {"discovered promotion", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4, {44, 1486, 62379, 2103487}},
+    {"symmetrical middlegame", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 4, {46, 2079, 89890, 3894594}},
+    {"illegal en passant (pin)", "3k4/3p4/8/K1P4r/8/8/8/8 b - - 0 1", 6, {18, 92, 1670, 10138, 185429, 1134888}},
+    {"illegal en passant (check)", "8/8/4k3/8/2p5/8/B2P2K1/8 w - - 0 1", 6, {13, 102, 1266, 10276, 135655, 1015133}},
+    {"en passant gives check", "8/8/1k6/2b5/2pP4/8/5K2/8 b - d3 0 1", 6, {15, 126, 1928, 13931, 206379, 1440467}},
+    {"castling gives check", "5k2/8/8/8/8/8/8/4K2R w K - 0 1", 6, {15, 66, 1198, 6399, 120330, 661072}},
+    {"long castling gives check", "3k4/8/8/8/8/8/8/R3K3 w Q - 0 1", 6, {16, 71, 1286, 7418, 141077, 803711}},
+    {"castling rights", "r3k2r/1b4bq/8/8/8/8/7B/R3K2R w KQkq - 0 1", 4, {26, 1141, 27826, 1274206}},
+    {"castling prevented", "r3k2r/8/3Q4/8/8/5q2/8/R3K2R b KQkq - 0 1", 4, {44, 1494, 50509, 1720476}},
+    {"promote out of check", "2K2r2/4P3/8/8/8/8/8/3k4 w - - 0 1", 6, {11, 133, 1442, 19174, 266199, 3821001}},
+    {"discovered check", "8/8/1P2K3/8/2n5/1q6/8/5k2 b - - 0 1", 5, {29, 165, 5160, 31961, 1004658}},
+    {"promote to give check", "4k3/1P6/8/8/8/8/K7/8 w - - 0 1", 6, {9, 40, 472, 2661, 38983, 217342}},
+    {"underpromote to check", "8/P1k5/K7/8/8/8/8/8 w - - 0 1", 6, {6, 27, 273, 1329, 18135, 92683}},
+    {"self stalemate", "K1k5/8/P7/8/8/8/8/8 w - - 0 1", 6, {2, 6, 13, 63, 382, 2217}},
+    {"stalemate and checkmate", "8/k1P5/8/1K6/8/8/8/8 w - - 0 1", 7, {10, 25, 268, 926, 10857, 43261, 567584}},
+    {"double check", "8/8/2k5/5q2/5n2/8/5K2/8 b - - 0 1", 4, {37, 183, 6559, 23527}},
+};
+
+// The reference validator is orders of magnitude slower, so it runs the suite
+// this many plies shallower.
+const int referencedepthcut = 1;
+
+// Shared subtree counts keyed by Zobrist key and depth, so transpositions are
+// counted once. Threads read and write entries without locks: the key is
+// stored XORed with the data, and a torn entry fails the check and is treated
+// as a miss.
+struct PerftEntry
+{
+    atomic<Bitboard> check;
+    atomic<Bitboard> data;
+};
+
+class PerftHash
+{
+    vector<PerftEntry> entries;
+    Bitboard mask;
+
+public:
+    PerftHash(size_t megabytes)
+    {
+        size_t count = 1;
+        while (count * 2 * sizeof(PerftEntry) <= megabytes << 20)
+            count *= 2;
+        entries = vector<PerftEntry>(count);
+        mask = count - 1;
+        clear();
+    }
+
+    void clear()
+    {
+        for (PerftEntry &e : entries)
+        {
+            e.check.store(0, memory_order_relaxed);
+            e.data.store(0, memory_order_relaxed);
+        }
+    }
+
+    // data packs the node count above an eight-bit depth.
+    bool probe(Bitboard key, int depth, unsigned long long &nodes) const
+    {
+        const PerftEntry &e = entries[key & mask];
+        Bitboard data = e.data.load(memory_order_relaxed);
+        if ((e.check.load(memory_order_relaxed) ^ data) != key || (int)(data & 0xFF) != depth)
+            return false;
+        nodes = data >> 8;
+        return true;
+    }
+
+    void store(Bitboard key, int depth, unsigned long long nodes)
+    {
+        PerftEntry &e = entries[key & mask];
+        Bitboard data = (nodes << 8) | depth;
+        e.check.store(key ^ data, memory_order_relaxed);
+        e.data.store(data, memory_order_relaxed);
+    }
+};
+
+struct PerftOptions
+{
+    Generator generate;
+    int threads;
+    PerftHash *hash;
+};
+
+static unsigned long long perft(Position &pos, int depth, const PerftOptions &options)
+{
+    if (depth == 0)
+        return 1;
+    MoveList list;
+    options.generate(pos, list);
+    if (depth == 1)
+        return list.size();
+
+    unsigned long long nodes = 0;
+    if (options.hash && options.hash->probe(pos.hashKey(), depth, nodes))
+        return nodes;
+
+    UndoInfo undo;
+    AttackState attacks;
+    for (Move m : list)
+    {
+        pos.make(m, undo, attacks);
+        nodes += perft(pos, depth - 1, options);
+        pos.unmake(m, undo, attacks);
+    }
+    if (options.hash)
+        options.hash->store(pos.hashKey(), depth, nodes);
+    return nodes;
+}
+
+// Counts each root move's subtree. Workers take root moves from a shared
+// counter, so uneven subtrees balance out, and counts[i] always belongs to
+// list[i], so the result does not depend on the thread count.
+static vector<unsigned long long> perftRoot(const Position &root, int depth, const MoveList &list,
+                                            const PerftOptions &options)
+{
+    vector<unsigned long long> counts(list.size());
+    atomic<int> next(0);
+    auto worker = [&]()
+    {
+        Position pos = root;
+        UndoInfo undo;
+        AttackState attacks;
+        for (int i = next++; i < list.size(); i = next++)
+        {
+            pos.make(list[i], undo, attacks);
+            counts[i] = perft(pos, depth - 1, options);
+            pos.unmake(list[i], undo, attacks);
+        }
+    };
+
+    vector<thread> pool;
+    for (int t = 1; t < options.threads; t++)
+        pool.emplace_back(worker);
+    worker();
+    for (thread &t : pool)
+        t.join();
+    return counts;
+}
+
+static unsigned long long perftTotal(const Position &root, int depth, const PerftOptions &options)
+{
+    MoveList list;
+    options.generate(root, list);
+    unsigned long long total = 0;
+    for (unsigned long long nodes : perftRoot(root, depth, list, options))
+        total += nodes;
+    return total;
+}
+
+// Compares the generator, run in its two stages as the search does, with the
+// reference at every node down to depth and prints the first position where
+// they disagree. Every move must also pass the standalone legality check.
+static bool verify(Position &pos, int depth)
+{
+    MoveList fast, reference;
+    generateLegalMoves(pos, fast, gencaptures);
+    generateLegalMoves(pos, fast, genquiets);
+    generateReferenceMoves(pos, reference);
+    for (Move m : reference)
+    {
+        if (!isLegalMove(pos, m))
+        {
+            printf("legal move %s rejected in %s\n", moveToString(m).c_str(), pos.fen().c_str());
+            return false;
+        }
+    }
+    sort(fast.moves, fast.moves + fast.count);
+    sort(reference.moves, reference.moves + reference.count);
+
+    if (fast.count != reference.count || !equal(fast.begin(), fast.end(), reference.begin()))
+    {
+        printf("mismatch in %s\n  generator:", pos.fen().c_str());
+        for (Move m : fast)
+            printf(" %s", moveToString(m).c_str());
+        printf("\n  reference:");
+        for (Move m : reference)
+            printf(" %s", moveToString(m).c_str());
+        printf("\n");
+        return false;
+    }
+    if (depth <= 1)
+        return true;
+
+    UndoInfo undo;
+    AttackState attacks;
+    for (Move m : fast)
+    {
+        pos.make(m, undo, attacks);
+        bool ok = verify(pos, depth - 1);
+        pos.unmake(m, undo, attacks);
+        if (!ok)
+            return false;
+    }
+    return true;
+}
+
+static double elapsedSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static double mnps(unsigned long long nodes, double seconds)
+{
+    return nodes / max(seconds, 1e-9) / 1e6;
+}
+
+static void divide(const Position &pos, int depth, const PerftOptions &options)
+{
+    auto start = chrono::steady_clock::now();
+    MoveList list;
+    options.generate(pos, list);
+    vector<unsigned long long> counts = perftRoot(pos, depth, list, options);
+    double seconds = elapsedSince(start);
+
+    unsigned long long total = 0;
+    for (int i = 0; i < list.size(); i++)
+    {
+        printf("%s: %llu\n", moveToString(list[i]).c_str(), counts[i]);
+        total += counts[i];
+    }
+    printf("\nmoves %d  nodes %llu  time %.3f s  %.2f Mnps\n", list.size(), total, seconds, mnps(total, seconds));
+}
+
+struct SuiteResult
+{
+    bool passed;
+    unsigned long long nodes;
+    double seconds;
+};
+
+static SuiteResult runSuite(const PerftOptions &options, int depthCut, bool verbose)
+{
+    SuiteResult result = {true, 0, 0};
+    for (const PerftCase &test : suite)
+    {
+        int depth = max(1, test.depth - depthCut);
+        Position pos;
+        pos.setFromFen(test.fen);
+        if (options.hash)
+            options.hash->clear();
+
+        auto start = chrono::steady_clock::now();
+        unsigned long long nodes = perftTotal(pos, depth, options);
+        double seconds = elapsedSince(start);
+        result.nodes += nodes;
+        result.seconds += seconds;
+
+        bool ok = nodes == test.nodes[depth - 1];
+        result.passed = result.passed && ok;
+        if (!verbose && ok)
+            continue;
+        printf("%-28s depth %d %12llu nodes %8.3f s %8.2f Mnps  %s", test.name, depth, nodes, seconds,
+               mnps(nodes, seconds), ok ? "ok" : "FAILED");
+        if (!ok)
+            printf(" (expected %llu)", test.nodes[depth - 1]);
+        printf("\n");
+    }
+    if (verbose)
+        printf("%-28s         %12llu nodes %8.3f s %8.2f Mnps  %s\n", "total", result.nodes, result.seconds,
+               mnps(result.nodes, result.seconds), result.passed ? "ok" : "FAILED");
+    return result;
+}
+
+// Times the suite, or one position when root is given, at 1, 2, 4, ...
+// threads up to maxThreads. Every run must produce the same node count.
+static bool runScaling(PerftOptions options, int maxThreads, const Position *root, int depth)
+{
+    bool passed = true;
+    unsigned long long firstNodes = 0;
+    double firstSeconds = 0;
+    printf("threads        nodes   time (s)     Mnps  speedup\n");
+    for (int threads = 1;; threads = min(threads * 2, maxThreads))
+    {
+        options.threads = threads;
+        SuiteResult result;
+        if (root)
+        {
+            if (options.hash)
+                options.hash->clear();
+            auto start = chrono::steady_clock::now();
+            result.nodes = perftTotal(*root, depth, options);
+            result.seconds = elapsedSince(start);
+            result.passed = true;
+        }
+        else
+            result = runSuite(options, 0, false);
+
+        if (threads == 1)
+        {
+            firstNodes = result.nodes;
+            firstSeconds = result.seconds;
+        }
+        bool ok = result.passed && result.nodes == firstNodes;
+        passed = passed && ok;
+        printf("%7d %12llu %10.3f %8.2f %8.2f  %s\n", threads, result.nodes, result.seconds,
+               mnps(result.nodes, result.seconds), firstSeconds / max(result.seconds, 1e-9), ok ? "ok" : "FAILED");
+        if (threads == maxThreads)
+            break;
+    }
+    return passed;
+}
+
+static bool runVerify(int depthCut)
+{
+    bool passed = true;
+    for (const PerftCase &test : suite)
+    {
+        int depth = max(1, test.depth - depthCut);
+        Position pos;
+        pos.setFromFen(test.fen);
+        bool ok = verify(pos, depth);
+        passed = passed && ok;
+        printf("%-28s depth %d  %s\n", test.name, depth, ok ? "ok" : "FAILED");
+    }
+    return passed;
+}
+
+static void usage()
+{
+    printf("usage: perft [--reference] [--threads N] [--hash MB] [--scaling] [\"<fen>\" <depth>]\n"
+           "       perft --verify\n"
+           "With no position, runs the built-in suite and exits non-zero on a count mismatch.\n"
+           "--reference counts with the original piece validator instead of the generator;\n"
+           "--threads splits the root moves across N threads;\n"
+           "--hash shares a table of subtree counts between them;\n"
+           "--scaling repeats the run at 1, 2, 4, ... up to N threads (default: all cores);\n"
+           "--verify compares the two move lists at every node of the suite.\n");
+}
+
+int main(int argc, char *argv[])
+{
+    initAttacks();
+
+    PerftOptions options = {generateAll, 1, nullptr};
+    bool verifyMode = false;
+    bool scalingMode = false;
+    int maxThreads = 0;
+    int hashMegabytes = 0;
+    int depthCut = 0;
+    int argi = 1;
+    for (; argi < argc && strncmp(argv[argi], "--", 2) == 0; argi++)
+    {
+        bool hasValue = argi + 1 < argc;
+        if (strcmp(argv[argi], "--reference") == 0)
+        {
+            options.generate = generateReferenceMoves;
+            depthCut = referencedepthcut;
+        }
+        else if (strcmp(argv[argi], "--verify") == 0)
+            verifyMode = true;
+        else if (strcmp(argv[argi], "--scaling") == 0)
+            scalingMode = true;
+        else if (strcmp(argv[argi], "--threads") == 0 && hasValue && atoi(argv[argi + 1]) > 0)
+            maxThreads = atoi(argv[++argi]);
+        else if (strcmp(argv[argi], "--hash") == 0 && hasValue && atoi(argv[argi + 1]) > 0)
+            hashMegabytes = atoi(argv[++argi]);
+        else
+        {
+            usage();
+            return 2;
+        }
+    }
+
+    if (verifyMode)
+        return runVerify(referencedepthcut) ? 0 : 1;
+
+    PerftHash *hash = hashMegabytes ? new PerftHash(hashMegabytes) : nullptr;
+    options.hash = hash;
+    if (scalingMode && !maxThreads)
+        maxThreads = max(1, (int)thread::hardware_concurrency());
+    options.threads = max(1, maxThreads);
+
+    int status = 0;
+    Position pos;
+    bool hasPosition = argi < argc;
+    if (hasPosition && (argc - argi != 2 || atoi(argv[argi + 1]) < 1))
+    {
+        usage();
+        status = 2;
+    }
+    else if (hasPosition && !pos.setFromFen(argv[argi]))
+    {
+        printf("invalid FEN: %s\n", argv[argi]);
+        status = 2;
+    }
+    else if (scalingMode)
+        status = runScaling(options, options.threads, hasPosition ? &pos : nullptr,
+                            hasPosition ? atoi(argv[argi + 1]) : 0)
+                     ? 0
+                     : 1;
+    else if (hasPosition)
+        divide(pos, atoi(argv[argi + 1]), options);
+    else
+        status = runSuite(options, depthCut, true).passed ? 0 : 1;
+
+    delete hash;
+    return status;
+}
@@ -0,0 +1,607 @@
+#include "position.h"
+#include "bitboard.h"
+#include "pst.h"
+#include "zobrist.h"
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+using namespace std;
+
+// Castling rights that survive a move touching each square.
+struct CastlingMasks
+{
+    unsigned char mask[64];
+};
+
+static constexpr CastlingMasks makeCastlingMasks()
+{
+    CastlingMasks masks{};
+    for (int sq = 0; sq < 64; sq++)
+        masks.mask[sq] = 15;
+    masks.mask[makeSquare(0, 7)] &= ~castlewhitequeen;
+    masks.mask[makeSquare(7, 7)] &= ~castlewhiteking;
+    masks.mask[makeSquare(4, 7)] &= ~(castlewhiteking | castlewhitequeen);
+    masks.mask[makeSquare(0, 0)] &= ~castleblackqueen;
+    masks.mask[makeSquare(7, 0)] &= ~castleblackking;
+    masks.mask[makeSquare(4, 0)] &= ~(castleblackking | castleblackqueen);
+    return masks;
+}
+
+static constexpr CastlingMasks castlingMasks = makeCastlingMasks();
+
+void Position::clear()
+{
+    for (int c = 0; c < 2; c++)
+    {
+        for (int t = 0; t < piecetypes; t++)
+        {
+            pieceBB[c][t] = 0;
+        }
+        colorBB[c] = 0;
+    }
+    occupiedBB = 0;
+    attackedBB[colorwhite] = attackedBB[colorblack] = 0;
+    checkersBB = 0;
+    side = colorwhite;
+    castling = 0;
+    enPassant = nosquare;
+    halfmove = 0;
+    key = 0;
+    pawnKey = 0;
+    mgScore = 0;
+    egScore = 0;
+    phase = 0;
+}
+
+bool Position::setFromFen(const string &fen)
+{
+    clear();
+    istringstream in(fen);
+    string placement, sideField, castlingField, epField;
+    int halfmoveField = 0;
+    in >> placement >> sideField >> castlingField >> epField >> halfmoveField;
+
+    const char *pieceChars = "prnbqk";
+    int x = 0, y = 0;
+    for (char ch : placement)
+    {
+        if (ch == '/')
+        {
+            y++;
+            x = 0;
+        }
+        else if (ch >= '1' && ch <= '8')
+        {
+            x += ch - '0';
+        }
+        else
+        {
+            const char *found = strchr(pieceChars, tolower(ch));
+            if (!found || x > 7 || y > 7)
+                return false;
+            putPiece(islower(ch) ? colorblack : colorwhite, (int)(found - pieceChars), makeSquare(x, y));
+            x++;
+        }
+    }
+    for (int color = colorwhite; color <= colorblack; color++)
+    {
+        Bitboard kings = pieceBB[color][pieceking];
+        if (!kings || (kings & (kings - 1)))
+            return false;
+    }
+
+    if (sideField != "w" && sideField != "b")
+        return false;
+    side = (sideField == "b") ? colorblack : colorwhite;
+    for (char ch : castlingField)
+    {
+        if (ch == 'K')
+            castling |= castlewhiteking;
+        else if (ch == 'Q')
+            castling |= castlewhitequeen;
+        else if (ch == 'k')
+            castling |= castleblackking;
+        else if (ch == 'q')
+            castling |= castleblackqueen;
+    }
+    // Move generation takes a right to mean king and rook are still at home,
+    // so a right claimed without them is dropped.
+    // Only the six home squares have masks that clear anything.
+    for (int sq = 0; sq < 64; sq++)
+    {
+        int color = squareY(sq) == 7 ? colorwhite : colorblack;
+        int type = squareX(sq) == 4 ? pieceking : piecerook;
+        if (pieceAt(sq) != makePiece(color, type))
+            castling &= castlingMasks.mask[sq];
+    }
+    if (epField.size() == 2 && epField[0] >= 'a' && epField[0] <= 'h' && epField[1] >= '1' && epField[1] <= '8')
+    {
+        // The square must be one an enemy pawn has just passed over on its
+        // double step: empty, on the third rank from that side, with the
+        // pawn in front of it. It is only kept when a pawn of ours can take.
+        int ep = makeSquare(epField[0] - 'a', '8' - epField[1]);
+        int pushed = (side == colorwhite) ? ep + 8 : ep - 8;
+        if (squareY(ep) != (side == colorwhite ? 2 : 5) || (occupiedBB & squareBit(ep)) ||
+            !(pieceBB[opponent(side)][piecepawn] & squareBit(pushed)))
+            return false;
+        if (pawnAttacks(opponent(side), ep) & pieceBB[side][piecepawn])
+            enPassant = ep;
+    }
+    halfmove = halfmoveField > 0 ? halfmoveField : 0;
+    key = computeKey();
+
+    refreshAttacks();
+    // The side that just moved cannot have left its king in check.
+    return !isSquareAttacked(kingSquare(opponent(side)), side);
+}
+
+string Position::fen() const
+{
+    const char *pieceChars = "PRNBQKprnbqk";
+    string result;
+    for (int y = 0; y < 8; y++)
+    {
+        int empty = 0;
+        for (int x = 0; x < 8; x++)
+        {
+            int piece = pieceAt(makeSquare(x, y));
+            if (piece == nopiece)
+            {
+                empty++;
+                continue;
+            }
+            if (empty)
+                result += (char)('0' + empty);
+            empty = 0;
+            result += pieceChars[piece];
+        }
+        if (empty)
+            result += (char)('0' + empty);
+        if (y < 7)
+            result += '/';
+    }
+
+    result += side == colorwhite ? " w " : " b ";
+    if (!castling)
+        result += '-';
+    if (castling & castlewhiteking)
+        result += 'K';
+    if (castling & castlewhitequeen)
+        result += 'Q';
+    if (castling & castleblackking)
+        result += 'k';
+    if (castling & castleblackqueen)
+        result += 'q';
+    result += ' ';
+    if (enPassant == nosquare)
+        result += '-';
+    else
+    {
+        result += (char)('a' + squareX(enPassant));
+        result += (char)('8' - squareY(enPassant));
+    }
+    result += ' ' + to_string(halfmove) + " 1";
+    return result;
+}
+
+void Position::putPiece(int color, int type, int sq)
+{
+    Bitboard bit = squareBit(sq);
+    pieceBB[color][type] |= bit;
+    colorBB[color] |= bit;
+    occupiedBB |= bit;
+    key ^= zobrist.pieces[color][type][sq];
+    if (type == piecepawn)
+        pawnKey ^= zobrist.pieces[color][type][sq];
+    int piece = makePiece(color, type);
+    mgScore += evalTables.mg[piece][sq];
+    egScore += evalTables.eg[piece][sq];
+    phase += evalTables.phase[type];
+}
+
+void Position::removePiece(int color, int type, int sq)
+{
+    Bitboard bit = squareBit(sq);
+    pieceBB[color][type] &= ~bit;
+    colorBB[color] &= ~bit;
+    occupiedBB &= ~bit;
+    key ^= zobrist.pieces[color][type][sq];
+    if (type == piecepawn)
+        pawnKey ^= zobrist.pieces[color][type][sq];
+    int piece = makePiece(color, type);
+    mgScore -= evalTables.mg[piece][sq];
+    egScore -= evalTables.eg[piece][sq];
+    phase -= evalTables.phase[type];
+}
+
+void Position::movePiece(int color, int type, int from, int to)
+{
+    Bitboard bits = squareBit(from) | squareBit(to);
+    pieceBB[color][type] ^= bits;
+    colorBB[color] ^= bits;
+    occupiedBB ^= bits;
+    Bitboard change = zobrist.pieces[color][type][from] ^ zobrist.pieces[color][type][to];
+    key ^= change;
+    if (type == piecepawn)
+        pawnKey ^= change;
+    int piece = makePiece(color, type);
+    mgScore += evalTables.mg[piece][to] - evalTables.mg[piece][from];
+    egScore += evalTables.eg[piece][to] - evalTables.eg[piece][from];
+}
+
+Bitboard Position::computeKey() const
+{
+    Bitboard k = 0;
+    for (int c = 0; c < 2; c++)
+    {
+        for (int t = 0; t < piecetypes; t++)
+        {
+            Bitboard bb = pieceBB[c][t];
+            while (bb)
+            {
+                k ^= zobrist.pieces[c][t][popLsb(bb)];
+            }
+        }
+    }
+    k ^= zobrist.castling[castling];
+    if (enPassant != nosquare)
+        k ^= zobrist.enPassantFile[squareX(enPassant)];
+    if (side == colorblack)
+        k ^= zobrist.side;
+    return k;
+}
+
+Bitboard Position::computePawnKey() const
+{
+    Bitboard k = 0;
+    for (int c = 0; c < 2; c++)
+    {
+        Bitboard bb = pieceBB[c][piecepawn];
+        while (bb)
+        {
+            k ^= zobrist.pieces[c][piecepawn][popLsb(bb)];
+        }
+    }
+    return k;
+}
+
+Bitboard Position::keyAfter(Move m) const
+{
+    int us = side;
+    int them = opponent(us);
+    int from = moveFrom(m);
+    int to = moveTo(m);
+    int flags = moveFlags(m);
+    int type = typeOf(pieceAt(from));
+    Bitboard result = key ^ zobrist.side;
+
+    if (flags == flagenpassant)
+        result ^= zobrist.pieces[them][piecepawn][(us == colorwhite) ? to + 8 : to - 8];
+    else if (isCapture(m))
+        result ^= zobrist.pieces[them][typeOf(pieceAt(to))][to];
+
+    result ^= zobrist.pieces[us][type][from];
+    result ^= zobrist.pieces[us][isPromotion(m) ? promotionType(m) : type][to];
+    if (flags == flagkingcastle)
+        result ^= zobrist.pieces[us][piecerook][to + 1] ^ zobrist.pieces[us][piecerook][to - 1];
+    else if (flags == flagqueencastle)
+        result ^= zobrist.pieces[us][piecerook][to - 2] ^ zobrist.pieces[us][piecerook][to + 1];
+
+    if (enPassant != nosquare)
+        result ^= zobrist.enPassantFile[squareX(enPassant)];
+    if (flags == flagdoublepush && (pawnAttacks(us, (from + to) / 2) & pieceBB[them][piecepawn]))
+        result ^= zobrist.enPassantFile[squareX(from)];
+
+    result ^= zobrist.castling[castling];
+    result ^= zobrist.castling[castling & castlingMasks.mask[from] & castlingMasks.mask[to]];
+    return result;
+}
+
+void Position::verifyKeys() const
+{
+    if (key != computeKey() || pawnKey != computePawnKey())
+        throw runtime_error("Zobrist key out of sync with the board");
+    int mg, eg, ph;
+    computeScores(mg, eg, ph);
+    if (mg != mgScore || eg != egScore || ph != phase)
+        throw runtime_error("Evaluation terms out of sync with the board");
+}
+
+void Position::computeScores(int &mg, int &eg, int &ph) const
+{
+    mg = eg = ph = 0;
+    for (int c = 0; c < 2; c++)
+    {
+        for (int t = 0; t < piecetypes; t++)
+        {
+            Bitboard bb = pieceBB[c][t];
+            while (bb)
+            {
+                int sq = popLsb(bb);
+                mg += evalTables.mg[makePiece(c, t)][sq];
+                eg += evalTables.eg[makePiece(c, t)][sq];
+                ph += evalTables.phase[t];
+            }
+        }
+    }
+}
+
+int Position::pieceAt(int sq) const
+{
+    Bitboard bit = squareBit(sq);
+    if (!(occupiedBB & bit))
+        return nopiece;
+    int color = (colorBB[colorwhite] & bit) ? colorwhite : colorblack;
+    for (int t = 0; t < piecetypes; t++)
+    {
+        if (pieceBB[color][t] & bit)
+            return makePiece(color, t);
+    }
+    return nopiece;
+}
+
+int Position::kingSquare(int color) const
+{
+    Bitboard king = pieceBB[color][pieceking];
+    return king ? lsb(king) : nosquare;
+}
+
+void Position::refreshAttacks()
+{
+    int them = opponent(side);
+    Bitboard king = pieceBB[side][pieceking];
+    checkersBB = king ? attackersTo(lsb(king), occupiedBB) & colorBB[them] : 0;
+
+    for (int c = 0; c < 2; c++)
+    {
+        Bitboard attacks = pawnSetAttacks(c, pieceBB[c][piecepawn]);
+        for (int t = piecerook; t < piecetypes; t++)
+        {
+            Bitboard bb = pieceBB[c][t];
+            while (bb)
+            {
+                attacks |= pieceAttacks(c, t, popLsb(bb), occupiedBB);
+            }
+        }
+        attackedBB[c] = attacks;
+    }
+}
+
+Bitboard Position::attackersTo(int sq, Bitboard occupied) const
+{
+    return (pawnAttacks(colorwhite, sq) & pieceBB[colorblack][piecepawn]) |
+           (pawnAttacks(colorblack, sq) & pieceBB[colorwhite][piecepawn]) |
+           (knightAttacks(sq) & (pieceBB[colorwhite][pieceknight] | pieceBB[colorblack][pieceknight])) |
+           (kingAttacks(sq) & (pieceBB[colorwhite][pieceking] | pieceBB[colorblack][pieceking])) |
+           (bishopAttacks(sq, occupied) & (pieceBB[colorwhite][piecebishop] | pieceBB[colorblack][piecebishop] |
+                                           pieceBB[colorwhite][piecequeen] | pieceBB[colorblack][piecequeen])) |
+           (rookAttacks(sq, occupied) & (pieceBB[colorwhite][piecerook] | pieceBB[colorblack][piecerook] |
+                                         pieceBB[colorwhite][piecequeen] | pieceBB[colorblack][piecequeen]));
+}
+
+bool Position::leavesKingAttacked(Move m) const
+{
+    int us = side;
+    Position next = *this;
+    next.applyMove(m);
+    Bitboard king = next.pieceBB[us][pieceking];
+    return king && (next.attackersTo(lsb(king), next.occupiedBB) & next.colorBB[opponent(us)]);
+}
+
+// Own pieces that are the only blocker between the king and an enemy slider.
+Bitboard Position::pinnedPieces(int color) const
+{
+    int king = kingSquare(color);
+    if (king == nosquare)
+        return 0;
+    int them = opponent(color);
+    Bitboard snipers = (rookAttacks(king, 0) & (pieceBB[them][piecerook] | pieceBB[them][piecequeen])) |
+                       (bishopAttacks(king, 0) & (pieceBB[them][piecebishop] | pieceBB[them][piecequeen]));
+    Bitboard pinned = 0;
+    while (snipers)
+    {
+        Bitboard blockers = betweenBB(king, popLsb(snipers)) & occupiedBB;
+        if (blockers && !(blockers & (blockers - 1)))
+            pinned |= blockers & colorBB[color];
+    }
+    return pinned;
+}
+
+void Position::make(Move m, UndoInfo &undo)
+{
+    undo.castling = castling;
+    undo.enPassant = enPassant;
+    undo.halfmoveClock = halfmove;
+    undo.key = key;
+#ifdef HASHCHECK
+    Bitboard expected = keyAfter(m);
+#endif
+    undo.captured = applyMove(m);
+    refreshAttacks();
+#ifdef HASHCHECK
+    verifyKeys();
+    if (key != expected)
+        throw runtime_error("keyAfter disagrees with make");
+#endif
+}
+
+void Position::make(Move m, UndoInfo &undo, AttackState &attacks)
+{
+    attacks.attacked[colorwhite] = attackedBB[colorwhite];
+    attacks.attacked[colorblack] = attackedBB[colorblack];
+    attacks.checkers = checkersBB;
+    make(m, undo);
+}
+
+void Position::makeNull(UndoInfo &undo)
+{
+    undo.castling = castling;
+    undo.enPassant = enPassant;
+    undo.halfmoveClock = halfmove;
+    undo.key = key;
+    undo.captured = nopiece;
+    if (enPassant != nosquare)
+        key ^= zobrist.enPassantFile[squareX(enPassant)];
+    enPassant = nosquare;
+    // A position before the null move repeating after it is no real
+    // repetition, so the count of reversible plies starts over.
+    halfmove = 0;
+    side = opponent(side);
+    key ^= zobrist.side;
+    // No piece moved, so the attack maps stand, and the side now to move
+    // can't be in check or the position before would have been illegal.
+    checkersBB = 0;
+#ifdef HASHCHECK
+    verifyKeys();
+#endif
+}
+
+void Position::unmakeNull(const UndoInfo &undo)
+{
+    side = opponent(side);
+    enPassant = undo.enPassant;
+    halfmove = undo.halfmoveClock;
+    key = undo.key;
+    checkersBB = 0;
+#ifdef HASHCHECK
+    verifyKeys();
+#endif
+}
+
+void Position::unmake(Move m, const UndoInfo &undo)
+{
+    undoMove(m, undo);
+    refreshAttacks();
+#ifdef HASHCHECK
+    verifyKeys();
+#endif
+}
+
+void Position::unmake(Move m, const UndoInfo &undo, const AttackState &attacks)
+{
+    undoMove(m, undo);
+    attackedBB[colorwhite] = attacks.attacked[colorwhite];
+    attackedBB[colorblack] = attacks.attacked[colorblack];
+    checkersBB = attacks.checkers;
+#ifdef HASHCHECK
+    verifyKeys();
+    Position rebuilt = *this;
+    rebuilt.refreshAttacks();
+    if (rebuilt.attackedBB[colorwhite] != attackedBB[colorwhite] ||
+        rebuilt.attackedBB[colorblack] != attackedBB[colorblack] || rebuilt.checkersBB != checkersBB)
+        throw runtime_error("Restored attack maps out of sync with the board");
+#endif
+}
+
+void Position::undoMove(Move m, const UndoInfo &undo)
+{
+    side = opponent(side);
+    int us = side;
+    int from = moveFrom(m);
+    int to = moveTo(m);
+    int flags = moveFlags(m);
+
+    if (isPromotion(m))
+    {
+        removePiece(us, promotionType(m), to);
+        putPiece(us, piecepawn, to);
+    }
+    else if (flags == flagkingcastle)
+    {
+        movePiece(us, piecerook, to - 1, to + 1);
+    }
+    else if (flags == flagqueencastle)
+    {
+        movePiece(us, piecerook, to + 1, to - 2);
+    }
+
+    movePiece(us, typeOf(pieceAt(to)), to, from);
+
+    if (undo.captured != nopiece)
+    {
+        int capturedSquare = to;
+        if (flags == flagenpassant)
+            capturedSquare = (us == colorwhite) ? to + 8 : to - 8;
+        putPiece(colorOf(undo.captured), typeOf(undo.captured), capturedSquare);
+    }
+
+    castling = undo.castling;
+    enPassant = undo.enPassant;
+    halfmove = undo.halfmoveClock;
+    // The pawn key is already back: piece moves XOR themselves out again.
+    key = undo.key;
+}
+
+int Position::applyMove(Move m)
+{
+    int us = side;
+    int them = opponent(us);
+    int from = moveFrom(m);
+    int to = moveTo(m);
+    int flags = moveFlags(m);
+    int type = typeOf(pieceAt(from));
+    int captured = nopiece;
+
+    if (flags == flagenpassant)
+    {
+        int capturedSquare = (us == colorwhite) ? to + 8 : to - 8;
+        captured = makePiece(them, piecepawn);
+        removePiece(them, piecepawn, capturedSquare);
+    }
+    else if (isCapture(m))
+    {
+        captured = pieceAt(to);
+        removePiece(them, typeOf(captured), to);
+    }
+
+    movePiece(us, type, from, to);
+
+    if (isPromotion(m))
+    {
+        removePiece(us, piecepawn, to);
+        putPiece(us, promotionType(m), to);
+    }
+    else if (flags == flagkingcastle)
+    {
+        movePiece(us, piecerook, to + 1, to - 1);
+    }
+    else if (flags == flagqueencastle)
+    {
+        movePiece(us, piecerook, to - 2, to + 1);
+    }
+
+    if (enPassant != nosquare)
+        key ^= zobrist.enPassantFile[squareX(enPassant)];
+    enPassant = nosquare;
+    if (flags == flagdoublepush)
+    {
+        int passed = (from + to) / 2;
+        if (pawnAttacks(us, passed) & pieceBB[them][piecepawn])
+        {
+            enPassant = passed;
+            key ^= zobrist.enPassantFile[squareX(passed)];
+        }
+    }
+
+    key ^= zobrist.castling[castling];
+    castling &= castlingMasks.mask[from] & castlingMasks.mask[to];
+    key ^= zobrist.castling[castling];
+
+    halfmove = (type == piecepawn || captured != nopiece) ? 0 : halfmove + 1;
+    side = them;
+    key ^= zobrist.side;
+    return captured;
+}
+
+Bitboard changedSquares(Move m, int mover)
+{
+    int to = moveTo(m);
+    Bitboard squares = squareBit(moveFrom(m)) | squareBit(to);
+    if (moveFlags(m) == flagenpassant)
+        squares |= squareBit((mover == colorwhite) ? to + 8 : to - 8);
+    else if (moveFlags(m) == flagkingcastle)
+        squares |= squareBit(to + 1) | squareBit(to - 1);
+    else if (moveFlags(m) == flagqueencastle)
+        squares |= squareBit(to - 2) | squareBit(to + 1);
+    return squares;
+}
@@ -0,0 +1,139 @@
+#ifndef POSITION_H
+#define POSITION_H
+
+#include "types.h"
+#include <string>
+
+const char startfen[] = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+const int fiftymoveplies = 100;
+
+// The repetition rule shared by the game and the search. keys[0..count) are
+// the keys of the positions before the current one, oldest first. Counts
+// those equal to key with the same side to move, looking back only as far
+// as the last capture or pawn move (halfmoveClock plies) in steps of two,
+// and stops once limit are found.
+template <typename Keys>
+int countRepetitions(const Keys &keys, int count, Bitboard key, int halfmoveClock, int limit)
+{
+    int found = 0;
+    int oldest = count - halfmoveClock;
+    for (int i = count - 2; i >= 0 && i >= oldest && found < limit; i -= 2)
+    {
+        if (keys[i] == key)
+            found++;
+    }
+    return found;
+}
+
+// State that make() overwrites and unmake() needs back.
+struct UndoInfo
+{
+    Bitboard key;
+    signed char captured;
+    unsigned char castling;
+    signed char enPassant;
+    unsigned short halfmoveClock;
+};
+
+// The attack maps and checkers as they stood before a move. They are kept
+// out of UndoInfo, which the game history stores for every ply; callers that
+// unmake straight away save them alongside it so unmake can copy them back
+// instead of rebuilding them.
+struct AttackState
+{
+    Bitboard attacked[2];
+    Bitboard checkers;
+};
+
+class Position
+{
+    Bitboard pieceBB[2][piecetypes];
+    Bitboard colorBB[2];
+    Bitboard occupiedBB;
+    unsigned char side;
+    unsigned char castling;
+    signed char enPassant;
+    unsigned short halfmove;
+    Bitboard attackedBB[2];
+    Bitboard checkersBB;
+    Bitboard key;
+    Bitboard pawnKey;
+    int mgScore;
+    int egScore;
+    int phase;
+
+    int applyMove(Move m);
+    void undoMove(Move m, const UndoInfo &undo);
+    void verifyKeys() const;
+
+public:
+    Position() { clear(); }
+
+    void clear();
+    bool setFromFen(const std::string &fen);
+    std::string fen() const;
+    void putPiece(int color, int type, int sq);
+    void removePiece(int color, int type, int sq);
+    void movePiece(int color, int type, int from, int to);
+
+    Bitboard pieces(int color, int type) const { return pieceBB[color][type]; }
+    Bitboard pieces(int color) const { return colorBB[color]; }
+    Bitboard occupied() const { return occupiedBB; }
+    int pieceAt(int sq) const;
+    int kingSquare(int color) const;
+
+    int sideToMove() const { return side; }
+    int castlingRights() const { return castling; }
+    int enPassantSquare() const { return enPassant; }
+    int halfmoveClock() const { return halfmove; }
+
+    // Zobrist keys are updated incrementally by every board change; the pawn
+    // key covers pawns only. Build with -DHASHCHECK to compare them, and the
+    // evaluation terms below, against a full recomputation after every make
+    // and unmake.
+    Bitboard hashKey() const { return key; }
+    Bitboard pawnHashKey() const { return pawnKey; }
+    Bitboard computeKey() const;
+    Bitboard computePawnKey() const;
+    // The key make(m) would produce, without changing the position, so the
+    // search can prefetch a child's table entry before making the move.
+    Bitboard keyAfter(Move m) const;
+
+    // Material and piece-square sums from white's side for the middle game
+    // and the endgame, and the phase that blends them. Kept current by the
+    // same board changes as the keys.
+    int middlegameScore() const { return mgScore; }
+    int endgameScore() const { return egScore; }
+    int gamePhase() const { return phase; }
+    void computeScores(int &mg, int &eg, int &ph) const;
+
+    // Attack maps and checkers are kept current by make/unmake: make rebuilds
+    // both maps from the tables, and unmake copies back an AttackState saved
+    // by make, or rebuilds when given none. After placing pieces by hand call
+    // refreshAttacks() once the position is complete.
+    void refreshAttacks();
+    Bitboard attackedBy(int color) const { return attackedBB[color]; }
+    Bitboard checkers() const { return checkersBB; }
+    bool isSquareAttacked(int sq, int byColor) const { return attackedBB[byColor] & squareBit(sq); }
+    bool inCheck(int color) const { return attackedBB[opponent(color)] & pieceBB[color][pieceking]; }
+    Bitboard pinnedPieces(int color) const;
+
+    // Every piece of either colour attacking sq, found by looking outwards
+    // from sq with each piece's pattern ("super-piece").
+    Bitboard attackersTo(int sq, Bitboard occupied) const;
+    bool leavesKingAttacked(Move m) const;
+
+    void make(Move m, UndoInfo &undo);
+    void make(Move m, UndoInfo &undo, AttackState &attacks);
+    void unmake(Move m, const UndoInfo &undo);
+    void unmake(Move m, const UndoInfo &undo, const AttackState &attacks);
+    // Passes the turn, for null-move pruning. Not allowed in check.
+    void makeNull(UndoInfo &undo);
+    void unmakeNull(const UndoInfo &undo);
+};
+
+// Squares whose contents a move changes, for views that mirror the position.
+Bitboard changedSquares(Move m, int mover);
+
+#endif
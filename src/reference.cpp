@@ -0,0 +1,536 @@
+#include "reference.h"
+#include <cstdlib>
+using namespace std;
+
+class ReferencePiece
+{
+protected:
+    int color;
+    bool hasMoved;
+    int boardX, boardY;
+    int pieceType;
+
+public:
+    ReferencePiece(int x, int y, int c, int type) : color(c), hasMoved(true), boardX(x), boardY(y), pieceType(type) {}
+
+    void setHasMoved(bool moved) { hasMoved = moved; }
+    int getColor() const { return color; }
+    int getBoardX() const { return boardX; }
+    int getBoardY() const { return boardY; }
+    bool getHasMoved() const { return hasMoved; }
+    int getPieceType() const { return pieceType; }
+
+    virtual bool isValidMove(int toX, int toY, ReferencePiece *board[8][8]) = 0;
+    virtual ~ReferencePiece() {}
+};
+
+class ReferencePawn : public ReferencePiece
+{
+public:
+    ReferencePawn(int x, int y, int c) : ReferencePiece(x, y, c, piecepawn) {}
+
+    bool isValidMove(int toX, int toY, ReferencePiece *board[8][8]) override
+    {
+        if (!board || toX < 0 || toX >= 8 || toY < 0 || toY >= 8)
+            return false;
+        int direction = (color == colorwhite) ? -1 : 1;
+        int startRow = (color == colorwhite) ? 6 : 1;
+
+        if (toX == boardX && toY == boardY + direction && !board[toX][toY])
+        {
+            return true;
+        }
+
+        if (toX == boardX && toY == boardY + 2 * direction &&
+            !board[toX][toY] && !board[toX][boardY + direction] &&
+            boardY == startRow && !hasMoved)
+        {
+            return true;
+        }
+
+        if ((toX == boardX + 1 || toX == boardX - 1) &&
+            toY == boardY + direction &&
+            board[toX][toY] && board[toX][toY]->getColor() != color)
+        {
+            return true;
+        }
+
+        return false;
+    }
+};
+
+class ReferenceRook : public ReferencePiece
+{
+public:
+    ReferenceRook(int x, int y, int c) : ReferencePiece(x, y, c, piecerook) {}
+
+    bool isValidMove(int toX, int toY, ReferencePiece *board[8][8]) override
+    {
+        if (!board || toX < 0 || toX >= 8 || toY < 0 || toY >= 8)
+            return false;
+        if (toX == boardX && toY == boardY)
+            return false;
+        if (toX != boardX && toY != boardY)
+            return false;
+
+        if (toX == boardX)
+        {
+            int step = (toY > boardY) ? 1 : -1;
+            for (int y = boardY + step; y != toY; y += step)
+            {
+                if (board[toX][y])
+                    return false;
+            }
+        }
+        else
+        {
+            int step = (toX > boardX) ? 1 : -1;
+            for (int x = boardX + step; x != toX; x += step)
+            {
+                if (board[x][toY])
+                    return false;
+            }
+        }
+
+        if (!board[toX][toY] || board[toX][toY]->getColor() != color)
+        {
+            return true;
+        }
+
+        return false;
+    }
+};
+
+class ReferenceKnight : public ReferencePiece
+{
+public:
+    ReferenceKnight(int x, int y, int c) : ReferencePiece(x, y, c, pieceknight) {}
+
+    bool isValidMove(int toX, int toY, ReferencePiece *board[8][8]) override
+    {
+        if (!board || toX < 0 || toX >= 8 || toY < 0 || toY >= 8)
+            return false;
+        int dx = abs(toX - boardX);
+        int dy = abs(toY - boardY);
+
+        if ((dx == 2 && dy == 1) || (dx == 1 && dy == 2))
+        {
+            if (!board[toX][toY] || board[toX][toY]->getColor() != color)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+};
+
+class ReferenceBishop : public ReferencePiece
+{
+public:
+    ReferenceBishop(int x, int y, int c) : ReferencePiece(x, y, c, piecebishop) {}
+
+    bool isValidMove(int toX, int toY, ReferencePiece *board[8][8]) override
+    {
+        if (!board || toX < 0 || toX >= 8 || toY < 0 || toY >= 8)
+            return false;
+        if (toX == boardX && toY == boardY)
+            return false;
+        if (abs(toX - boardX) != abs(toY - boardY))
+            return false;
+
+        int stepX = (toX > boardX) ? 1 : -1;
+        int stepY = (toY > boardY) ? 1 : -1;
+
+        int x = boardX + stepX;
+        int y = boardY + stepY;
+        while (x != toX && y != toY)
+        {
+            if (board[x][y])
+                return false;
+            x += stepX;
+            y += stepY;
+        }
+
+        if (!board[toX][toY] || board[toX][toY]->getColor() != color)
+        {
+            return true;
+        }
+
+        return false;
+    }
+};
+
+class ReferenceQueen : public ReferencePiece
+{
+public:
+    ReferenceQueen(int x, int y, int c) : ReferencePiece(x, y, c, piecequeen) {}
+
+    bool isValidMove(int toX, int toY, ReferencePiece *board[8][8]) override
+    {
+        if (!board || toX < 0 || toX >= 8 || toY < 0 || toY >= 8)
+            return false;
+        if (toX == boardX && toY == boardY)
+            return false;
+        if (toX != boardX && toY != boardY &&
+            abs(toX - boardX) != abs(toY - boardY))
+        {
+            return false;
+        }
+
+        if (toX == boardX)
+        {
+            int step = (toY > boardY) ? 1 : -1;
+            for (int y = boardY + step; y != toY; y += step)
+            {
+                if (board[toX][y])
+                    return false;
+            }
+        }
+        else if (toY == boardY)
+        {
+            int step = (toX > boardX) ? 1 : -1;
+            for (int x = boardX + step; x != toX; x += step)
+            {
+                if (board[x][toY])
+                    return false;
+            }
+        }
+        else
+        {
+            int stepX = (toX > boardX) ? 1 : -1;
+            int stepY = (toY > boardY) ? 1 : -1;
+
+            int x = boardX + stepX;
+            int y = boardY + stepY;
+            while (x != toX && y != toY)
+            {
+                if (board[x][y])
+                    return false;
+                x += stepX;
+                y += stepY;
+            }
+        }
+
+        if (!board[toX][toY] || board[toX][toY]->getColor() != color)
+        {
+            return true;
+        }
+
+        return false;
+    }
+};
+
+class ReferenceKing : public ReferencePiece
+{
+public:
+    ReferenceKing(int x, int y, int c) : ReferencePiece(x, y, c, pieceking) {}
+
+    bool isValidMove(int toX, int toY, ReferencePiece *board[8][8]) override
+    {
+        if (!board || toX < 0 || toX >= 8 || toY < 0 || toY >= 8)
+            return false;
+        int dx = abs(toX - boardX);
+        int dy = abs(toY - boardY);
+
+        if (dx <= 1 && dy <= 1 && (dx != 0 || dy != 0))
+        {
+            if (!board[toX][toY] || board[toX][toY]->getColor() != color)
+            {
+                return true;
+            }
+        }
+
+        if (!hasMoved && dy == 0 && dx == 2)
+        {
+            int rookX = (toX > boardX) ? 7 : 0;
+            int step = (toX > boardX) ? 1 : -1;
+
+            if (!board[rookX][boardY] || board[rookX][boardY]->getPieceType() != piecerook ||
+                board[rookX][boardY]->getHasMoved())
+            {
+                return false;
+            }
+
+            for (int x = boardX + step; x != rookX; x += step)
+            {
+                if (board[x][boardY])
+                    return false;
+            }
+
+            return true;
+        }
+
+        return false;
+    }
+};
+
+// The game-side checks that used to surround isValidMove, on a board built
+// from a Position. hasMoved is recovered from the castling rights and the pawn
+// start rows, and the double-moved pawn from the en passant square.
+class ReferenceBoard
+{
+    ReferencePiece *pieceBoard[8][8];
+    ReferencePiece *pieces[64];
+    int pieceCount;
+    int currentTurn;
+    ReferencePiece *lastDoubleMovedPawn;
+
+    ReferenceBoard(const ReferenceBoard &) = delete;
+    ReferenceBoard &operator=(const ReferenceBoard &) = delete;
+
+    ReferencePiece *createPiece(int color, int type, int x, int y)
+    {
+        switch (type)
+        {
+        case piecepawn:
+            return new ReferencePawn(x, y, color);
+        case piecerook:
+            return new ReferenceRook(x, y, color);
+        case pieceknight:
+            return new ReferenceKnight(x, y, color);
+        case piecebishop:
+            return new ReferenceBishop(x, y, color);
+        case piecequeen:
+            return new ReferenceQueen(x, y, color);
+        default:
+            return new ReferenceKing(x, y, color);
+        }
+    }
+
+    bool isKingInCheck(int playerColor, int kingX, int kingY, ReferencePiece *board[8][8])
+    {
+        if (!board || kingX < 0 || kingX >= 8 || kingY < 0 || kingY >= 8)
+            return false;
+
+        for (int x = 0; x < 8; x++)
+        {
+            for (int y = 0; y < 8; y++)
+            {
+                ReferencePiece *piece = board[x][y];
+                if (piece && piece->getColor() != playerColor)
+                {
+                    if (piece->isValidMove(kingX, kingY, board))
+                    {
+                        return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    bool findKingPosition(int playerColor, int &kingX, int &kingY, ReferencePiece *board[8][8])
+    {
+        if (!board)
+            return false;
+        for (int x = 0; x < 8; x++)
+        {
+            for (int y = 0; y < 8; y++)
+            {
+                ReferencePiece *piece = board[x][y];
+                if (piece && piece->getPieceType() == pieceking && piece->getColor() == playerColor)
+                {
+                    kingX = x;
+                    kingY = y;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool wouldKingBeInCheck(ReferencePiece *piece, int fromX, int fromY, int toX, int toY, bool isEnPassant, bool isCastling)
+    {
+        if (!piece || toX < 0 || toX >= 8 || toY < 0 || toY >= 8 ||
+            fromX < 0 || fromX >= 8 || fromY < 0 || fromY >= 8)
+        {
+            return false;
+        }
+
+        int playerColor = piece->getColor();
+        ReferencePiece *tempBoard[8][8];
+        for (int i = 0; i < 8; i++)
+            for (int j = 0; j < 8; j++)
+                tempBoard[i][j] = pieceBoard[i][j];
+
+        if (isEnPassant)
+        {
+            tempBoard[toX][fromY] = nullptr;
+        }
+        else if (tempBoard[toX][toY])
+        {
+            tempBoard[toX][toY] = nullptr;
+        }
+
+        if (isCastling)
+        {
+            int rookFromX = (toX > fromX) ? 7 : 0;
+            int rookToX = (toX > fromX) ? 5 : 3;
+            ReferencePiece *rook = tempBoard[rookFromX][fromY];
+            if (rook)
+            {
+                tempBoard[rookFromX][fromY] = nullptr;
+                tempBoard[rookToX][fromY] = rook;
+            }
+        }
+
+        tempBoard[fromX][fromY] = nullptr;
+        tempBoard[toX][toY] = piece;
+
+        int kingX, kingY;
+        if (piece->getPieceType() == pieceking)
+        {
+            kingX = toX;
+            kingY = toY;
+        }
+        else
+        {
+            if (!findKingPosition(playerColor, kingX, kingY, tempBoard))
+            {
+                return false;
+            }
+        }
+
+        return isKingInCheck(playerColor, kingX, kingY, tempBoard);
+    }
+
+    bool isValidEnPassant(ReferencePiece *pawn, int toX, int toY)
+    {
+        if (!pawn || pawn->getPieceType() != piecepawn || toX < 0 || toX >= 8 || toY < 0 || toY >= 8)
+            return false;
+
+        int direction = (pawn->getColor() == colorwhite) ? -1 : 1;
+        if (toY != pawn->getBoardY() + direction)
+            return false;
+
+        if (abs(toX - pawn->getBoardX()) == 1 && !pieceBoard[toX][toY])
+        {
+            ReferencePiece *target = pieceBoard[toX][pawn->getBoardY()];
+            if (target && target == lastDoubleMovedPawn &&
+                target->getPieceType() == piecepawn &&
+                target->getColor() != pawn->getColor())
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool castlingAllowed(ReferencePiece *king, int toX)
+    {
+        int oldX = king->getBoardX();
+        int oldY = king->getBoardY();
+        int step = (toX > oldX) ? 1 : -1;
+        if (isKingInCheck(currentTurn, oldX, oldY, pieceBoard))
+            return false;
+        return !wouldKingBeInCheck(king, oldX, oldY, oldX + step, oldY, false, false) &&
+               !wouldKingBeInCheck(king, oldX, oldY, oldX + 2 * step, oldY, false, false);
+    }
+
+    void addMoves(MoveList &list, ReferencePiece *piece, int toX, int toY, bool isEnPassant, bool isCastling)
+    {
+        int from = makeSquare(piece->getBoardX(), piece->getBoardY());
+        int to = makeSquare(toX, toY);
+        bool capture = pieceBoard[toX][toY] != nullptr;
+
+        if (isCastling)
+            list.add(makeMove(from, to, toX > piece->getBoardX() ? flagkingcastle : flagqueencastle));
+        else if (isEnPassant)
+            list.add(makeMove(from, to, flagenpassant));
+        else if (piece->getPieceType() == piecepawn && (toY == 0 || toY == 7))
+        {
+            // The game always promoted to a queen; list every choice so the
+            // counts match the generator.
+            for (int type : promotionPieces)
+                list.add(makeMove(from, to, promotionFlags(type, capture)));
+        }
+        else if (piece->getPieceType() == piecepawn && abs(toY - piece->getBoardY()) == 2)
+            list.add(makeMove(from, to, flagdoublepush));
+        else
+            list.add(makeMove(from, to, capture ? flagcapture : flagquiet));
+    }
+
+public:
+    ReferenceBoard(const Position &pos) : pieceCount(0), currentTurn(pos.sideToMove()), lastDoubleMovedPawn(nullptr)
+    {
+        for (int x = 0; x < 8; x++)
+            for (int y = 0; y < 8; y++)
+                pieceBoard[x][y] = nullptr;
+
+        int rights = pos.castlingRights();
+        for (int sq = 0; sq < 64; sq++)
+        {
+            int piece = pos.pieceAt(sq);
+            if (piece == nopiece)
+                continue;
+            int color = colorOf(piece);
+            int type = typeOf(piece);
+            int x = squareX(sq);
+            int y = squareY(sq);
+            int homeRow = (color == colorwhite) ? 7 : 0;
+            int kingRight = (color == colorwhite) ? castlewhiteking : castleblackking;
+            int queenRight = (color == colorwhite) ? castlewhitequeen : castleblackqueen;
+
+            ReferencePiece *created = createPiece(color, type, x, y);
+            if (type == piecepawn)
+                created->setHasMoved(y != ((color == colorwhite) ? 6 : 1));
+            else if (type == pieceking)
+                created->setHasMoved(!(rights & (kingRight | queenRight)));
+            else if (type == piecerook && y == homeRow && x == 7)
+                created->setHasMoved(!(rights & kingRight));
+            else if (type == piecerook && y == homeRow && x == 0)
+                created->setHasMoved(!(rights & queenRight));
+            pieces[pieceCount++] = created;
+            pieceBoard[x][y] = created;
+        }
+
+        int ep = pos.enPassantSquare();
+        if (ep != nosquare)
+            lastDoubleMovedPawn = pieceBoard[squareX(ep)][squareY(ep) + (currentTurn == colorwhite ? 1 : -1)];
+    }
+
+    ~ReferenceBoard()
+    {
+        for (int i = 0; i < pieceCount; i++)
+            delete pieces[i];
+    }
+
+    void generateMoves(MoveList &list)
+    {
+        for (int fromX = 0; fromX < 8; fromX++)
+        {
+            for (int fromY = 0; fromY < 8; fromY++)
+            {
+                ReferencePiece *piece = pieceBoard[fromX][fromY];
+                if (!piece || piece->getColor() != currentTurn)
+                {
+                    continue;
+                }
+                for (int toX = 0; toX < 8; toX++)
+                {
+                    for (int toY = 0; toY < 8; toY++)
+                    {
+                        bool isEnPassant = isValidEnPassant(piece, toX, toY);
+                        bool isCastling = piece->getPieceType() == pieceking &&
+                                          abs(toX - fromX) == 2 && toY == fromY;
+                        if (!(piece->isValidMove(toX, toY, pieceBoard) || isEnPassant) ||
+                            wouldKingBeInCheck(piece, fromX, fromY, toX, toY, isEnPassant, isCastling))
+                        {
+                            continue;
+                        }
+                        if (isCastling && !castlingAllowed(piece, toX))
+                            continue;
+                        addMoves(list, piece, toX, toY, isEnPassant, isCastling);
+                    }
+                }
+            }
+        }
+    }
+};
+
+void generateReferenceMoves(const Position &pos, MoveList &list)
+{
+    ReferenceBoard board(pos);
+    board.generateMoves(list);
+}
@@ -0,0 +1,13 @@
+#ifndef REFERENCE_H
+#define REFERENCE_H
+
+#include "movegen.h"
+#include "position.h"
+
+// The original object-oriented validator: each piece checks its own geometry
+// on a mailbox board and a move is kept if no enemy piece could then reach the
+// king. It probes every from/to pair and shares no code with the bitboard
+// generator, which makes it slow but a useful reference for perft.
+void generateReferenceMoves(const Position &pos, MoveList &list);
+
+#endif
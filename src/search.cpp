@@ -0,0 +1,508 @@
+#include "search.h"
+#include "eval.h"
+#include "movegen.h"
+#include "movepick.h"
+#include "see.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+using namespace std;
+
+// Nodes between clock reads; a power of two so the test is a mask.
+const int timecheckinterval = 2048;
+const int historylimit = 1 << 20;
+
+// Null move: the reduction grows with depth, and cutoffs from depth
+// nullverifydepth on are confirmed by a search without null moves.
+const int nullmindepth = 3;
+const int nullverifydepth = 8;
+
+// Reverse futility cuts at depth d when the evaluation beats beta by
+// futilitymargin * d; forward futility skips quiet moves when it falls short
+// of alpha by as much.
+const int reversefutilitydepth = 6;
+const int futilitydepth = 3;
+const int futilitymargin = 100;
+
+// Late-move reductions start at this depth and after this many moves.
+const int lmrmindepth = 3;
+const int lmrminmoves = 3;
+const int lmrtablesize = 64;
+
+static int reductionTable[lmrtablesize][lmrtablesize];
+
+static void initReductions()
+{
+    for (int depth = 1; depth < lmrtablesize; depth++)
+    {
+        for (int moves = 1; moves < lmrtablesize; moves++)
+            reductionTable[depth][moves] = (int)(0.75 + log(depth) * log(moves) / 2.25);
+    }
+}
+
+static bool hasNonPawnMaterial(const Position &pos, int color)
+{
+    return pos.pieces(color) & ~pos.pieces(color, piecepawn) & ~pos.pieces(color, pieceking);
+}
+
+static void addHistory(int &entry, int bonus)
+{
+    entry = max(-historylimit, min(entry + bonus, historylimit));
+}
+
+// A quiet cutoff becomes a killer for this ply and the countermove to the
+// opponent's last move; its history rises and that of the quiet moves
+// searched before it falls.
+static void updateQuietStats(SearchThread &t, Move m, Move previous, int depth, int ply,
+                             const Move *triedQuiets, int triedCount)
+{
+    if (t.killers[ply][0] != m)
+    {
+        t.killers[ply][1] = t.killers[ply][0];
+        t.killers[ply][0] = m;
+    }
+    if (previous != nomove)
+        t.counterMoves[t.pos.pieceAt(moveTo(previous))][moveTo(previous)] = m;
+
+    int(*history)[64] = t.history[t.pos.sideToMove()];
+    addHistory(history[moveFrom(m)][moveTo(m)], depth * depth);
+    for (int i = 0; i < triedCount; i++)
+        addHistory(history[moveFrom(triedQuiets[i])][moveTo(triedQuiets[i])], -depth * depth);
+}
+
+// Mate scores are stored relative to the node rather than the root, so an
+// entry stays correct when the position is reached at another ply.
+static int scoreToTT(int score, int ply)
+{
+    if (score >= matebound)
+        return score + ply;
+    if (score <= -matebound)
+        return score - ply;
+    return score;
+}
+
+static int scoreFromTT(int score, int ply)
+{
+    if (score >= matebound)
+        return score - ply;
+    if (score <= -matebound)
+        return score + ply;
+    return score;
+}
+
+Search::Search(TranspositionTable &table, int threadCount) : tt(table), stopped(false), useHardDeadline(false), network(nullptr), useNetwork(false)
+{
+    initReductions();
+    setThreads(threadCount);
+}
+
+Search::~Search()
+{
+    for (SearchThread *t : threads)
+        delete t;
+}
+
+void Search::setThreads(int count)
+{
+    count = max(count, 1);
+    while ((int)threads.size() > count)
+    {
+        delete threads.back();
+        threads.pop_back();
+    }
+    while ((int)threads.size() < count)
+    {
+        SearchThread *t = new SearchThread();
+        t->id = (int)threads.size();
+        threads.push_back(t);
+    }
+}
+
+void Search::makeMove(SearchThread &t, Move m, UndoInfo &undo, AttackState &attacks)
+{
+    t.keys.push_back(t.pos.hashKey());
+    if (useNetwork)
+        t.accumulators.push(t.pos, m);
+    t.pos.make(m, undo, attacks);
+}
+
+void Search::unmakeMove(SearchThread &t, Move m, const UndoInfo &undo, const AttackState &attacks)
+{
+    t.pos.unmake(m, undo, attacks);
+    if (useNetwork)
+        t.accumulators.pop();
+    t.keys.pop_back();
+}
+
+void Search::makeNullMove(SearchThread &t, UndoInfo &undo)
+{
+    t.keys.push_back(t.pos.hashKey());
+    if (useNetwork)
+        t.accumulators.pushNull();
+    t.pos.makeNull(undo);
+}
+
+void Search::unmakeNullMove(SearchThread &t, const UndoInfo &undo)
+{
+    t.pos.unmakeNull(undo);
+    if (useNetwork)
+        t.accumulators.pop();
+    t.keys.pop_back();
+}
+
+int Search::evaluateNode(SearchThread &t)
+{
+    return useNetwork ? t.accumulators.evaluate(*network, t.pos) : evaluate(t.pos, t.pawnTable);
+}
+
+bool Search::isDraw(const SearchThread &t) const
+{
+    if (t.pos.halfmoveClock() >= fiftymoveplies)
+        return true;
+    // Inside the tree a single repetition counts as a draw: whichever side
+    // gains from it could repeat again.
+    return countRepetitions(t.keys, (int)t.keys.size(), t.pos.hashKey(), t.pos.halfmoveClock(), 1) > 0;
+}
+
+void Search::checkTime()
+{
+    if (useHardDeadline && chrono::steady_clock::now() >= hardDeadline)
+        stopped = true;
+}
+
+double Search::elapsed() const
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+int Search::pvs(SearchThread &t, int alpha, int beta, int depth, int ply)
+{
+    Position &pos = t.pos;
+    bool inCheck = pos.checkers() != 0;
+    if (inCheck)
+        depth++;
+    if (depth <= 0)
+        return quiesce(t, alpha, beta, ply);
+
+    t.pvLength[ply] = ply;
+    if ((++t.nodes & (timecheckinterval - 1)) == 0 && t.id == 0)
+        checkTime();
+    if (stopped.load(memory_order_relaxed))
+        return 0;
+    if (ply > 0 && isDraw(t))
+        return 0;
+    if (ply >= maxply - 1)
+        return evaluateNode(t);
+
+    // Bounds from the table may only end non-PV nodes, so the PV is always
+    // searched and complete.
+    bool pvNode = beta - alpha > 1;
+    Move ttMove = nomove;
+    TTHit hit;
+    t.ttStats.probes++;
+    if (tt.probe(pos.hashKey(), hit))
+    {
+        t.ttStats.hits++;
+        ttMove = hit.move;
+        int ttScore = scoreFromTT(hit.score, ply);
+        if (!pvNode && ply > 0 && hit.depth >= depth &&
+            (hit.bound == boundexact || (hit.bound == boundlower && ttScore >= beta) ||
+             (hit.bound == boundupper && ttScore <= alpha)))
+        {
+            return ttScore;
+        }
+    }
+
+    int us = pos.sideToMove();
+    Move previous = ply > 0 ? t.moveStack[ply - 1] : nomove;
+    int staticEval = inCheck ? -infinitescore : evaluateNode(t);
+    UndoInfo undo;
+    AttackState attacks;
+
+    if (options.futilityPruning && !pvNode && !inCheck && depth <= reversefutilitydepth && abs(beta) < matebound &&
+        staticEval - futilitymargin * depth >= beta)
+    {
+        return staticEval;
+    }
+
+    // Passing is almost always worse than the best move, so if even that
+    // fails high the node will. Not after another null move, and not
+    // without pieces, where zugzwang makes passing the best option.
+    if (options.nullMove && !pvNode && !inCheck && ply >= t.nullMinPly && previous != nomove &&
+        depth >= nullmindepth && staticEval >= beta && abs(beta) < matebound && hasNonPawnMaterial(pos, us))
+    {
+        int nullDepth = depth - 1 - (3 + depth / 6);
+        t.moveStack[ply] = nomove;
+        makeNullMove(t, undo);
+        int score = -pvs(t, -beta, -beta + 1, nullDepth, ply + 1);
+        unmakeNullMove(t, undo);
+        if (stopped.load(memory_order_relaxed))
+            return 0;
+        if (score >= beta)
+        {
+            if (score >= matebound)
+                score = beta;
+            if (depth < nullverifydepth)
+                return score;
+            int savedMinPly = t.nullMinPly;
+            t.nullMinPly = ply + 3 * max(nullDepth, 0) / 4 + 1;
+            int verified = pvs(t, beta - 1, beta, nullDepth, ply);
+            t.nullMinPly = savedMinPly;
+            if (verified >= beta)
+                return score;
+        }
+    }
+
+    bool futile = options.futilityPruning && !pvNode && !inCheck && depth <= futilitydepth &&
+                  abs(alpha) < matebound && staticEval + futilitymargin * depth <= alpha;
+
+    Move counter = previous != nomove ? t.counterMoves[pos.pieceAt(moveTo(previous))][moveTo(previous)] : nomove;
+    MovePicker picker(pos, ttMove, t.killers[ply], counter, t.history[us]);
+
+    int originalAlpha = alpha;
+    int bestScore = -infinitescore;
+    Move bestMove = nomove;
+    Move triedQuiets[maxmovelist];
+    int triedCount = 0;
+    int moveCount = 0;
+    Move m;
+    while ((m = picker.next()) != nomove)
+    {
+        int i = moveCount++;
+        bool quiet = !isCapture(m) && !isPromotion(m);
+        bool special = m == t.killers[ply][0] || m == t.killers[ply][1] || m == counter;
+        int moveHistory = t.history[us][moveFrom(m)][moveTo(m)];
+        tt.prefetch(pos.keyAfter(m));
+        t.moveStack[ply] = m;
+        makeMove(t, m, undo, attacks);
+        bool givesCheck = pos.checkers() != 0;
+        if (futile && quiet && !givesCheck && i > 0)
+        {
+            unmakeMove(t, m, undo, attacks);
+            continue;
+        }
+
+        int newDepth = depth - 1;
+        int score;
+        if (i == 0)
+            score = -pvs(t, -beta, -alpha, newDepth, ply + 1);
+        else
+        {
+            int reduction = 0;
+            if (options.lateMoveReductions && quiet && !special && !inCheck && !givesCheck && depth >= lmrmindepth &&
+                i >= lmrminmoves)
+            {
+                reduction = reductionTable[min(depth, lmrtablesize - 1)][min(moveCount, lmrtablesize - 1)];
+                reduction -= moveHistory / (historylimit / 2);
+                if (pvNode)
+                    reduction--;
+                reduction = max(0, min(reduction, newDepth - 1));
+            }
+
+            // Later moves only have to be shown worse than the first, which a
+            // null window does cheaply; re-search the few that are not, first
+            // at full depth if they were reduced.
+            score = -pvs(t, -alpha - 1, -alpha, newDepth - reduction, ply + 1);
+            if (reduction > 0 && score > alpha)
+                score = -pvs(t, -alpha - 1, -alpha, newDepth, ply + 1);
+            if (score > alpha && score < beta)
+                score = -pvs(t, -beta, -alpha, newDepth, ply + 1);
+        }
+        unmakeMove(t, m, undo, attacks);
+
+        if (stopped.load(memory_order_relaxed))
+            return 0;
+        if (score > bestScore)
+        {
+            bestScore = score;
+            bestMove = m;
+            if (score > alpha)
+            {
+                alpha = score;
+                if (ply == 0)
+                    t.iterationBest = m;
+                t.pvTable[ply][ply] = m;
+                for (int j = ply + 1; j < t.pvLength[ply + 1]; j++)
+                    t.pvTable[ply][j] = t.pvTable[ply + 1][j];
+                t.pvLength[ply] = max(t.pvLength[ply + 1], ply + 1);
+                if (alpha >= beta)
+                {
+                    t.failHighs++;
+                    if (i == 0)
+                        t.failHighsFirst++;
+                    if (quiet)
+                        updateQuietStats(t, m, previous, depth, ply, triedQuiets, triedCount);
+                    break;
+                }
+            }
+        }
+        if (quiet)
+            triedQuiets[triedCount++] = m;
+    }
+    t.movesGenerated += picker.generatedCount();
+    if (moveCount == 0)
+        return inCheck ? -matescore + ply : 0;
+
+    int bound = bestScore >= beta ? boundlower : bestScore > originalAlpha ? boundexact : boundupper;
+    t.ttStats.stores++;
+    if (tt.store(pos.hashKey(), bound == boundupper ? nomove : bestMove, scoreToTT(bestScore, ply), depth, bound))
+        t.ttStats.collisions++;
+    return bestScore;
+}
+
+// Searches captures until the position is quiet, so no leaf is scored in the
+// middle of an exchange. The side to move may stand pat on the static
+// evaluation rather than capture, except in check, where every evasion is
+// searched. Captures that lose material by static exchange are skipped.
+int Search::quiesce(SearchThread &t, int alpha, int beta, int ply)
+{
+    Position &pos = t.pos;
+    t.pvLength[ply] = ply;
+    t.qnodes++;
+    if ((++t.nodes & (timecheckinterval - 1)) == 0 && t.id == 0)
+        checkTime();
+    if (stopped.load(memory_order_relaxed))
+        return 0;
+    if (isDraw(t))
+        return 0;
+    if (ply >= maxply - 1)
+        return evaluateNode(t);
+
+    bool inCheck = pos.checkers() != 0;
+    int bestScore = -infinitescore;
+    if (!inCheck)
+    {
+        bestScore = evaluateNode(t);
+        if (bestScore >= beta)
+            return bestScore;
+        alpha = max(alpha, bestScore);
+    }
+
+    MovePicker picker(pos, t.history[pos.sideToMove()]);
+    int moveCount = 0;
+    UndoInfo undo;
+    AttackState attacks;
+    Move m;
+    while ((m = picker.next()) != nomove)
+    {
+        moveCount++;
+        if (!inCheck && options.seePruning && see(pos, m) < 0)
+            continue;
+        makeMove(t, m, undo, attacks);
+        int score = -quiesce(t, -beta, -alpha, ply + 1);
+        unmakeMove(t, m, undo, attacks);
+
+        if (stopped.load(memory_order_relaxed))
+            return 0;
+        if (score > bestScore)
+        {
+            bestScore = score;
+            if (score > alpha)
+            {
+                alpha = score;
+                if (alpha >= beta)
+                    break;
+            }
+        }
+    }
+    t.movesGenerated += picker.generatedCount();
+    if (inCheck && moveCount == 0)
+        return -matescore + ply;
+    return bestScore;
+}
+
+void Search::helperSearch(SearchThread &t, int maxDepth)
+{
+    for (int depth = 1 + (t.id & 1); depth <= maxDepth && !stopped; depth++)
+        pvs(t, -infinitescore, infinitescore, depth, 0);
+}
+
+SearchInfo Search::think(const Position &root, const vector<Bitboard> &history, const SearchLimits &limits)
+{
+    tt.newSearch();
+    start = chrono::steady_clock::now();
+    useHardDeadline = limits.hardTime > 0;
+    hardDeadline = start + chrono::milliseconds(limits.hardTime);
+    useNetwork = network && network->loaded() && options.nnue;
+    for (SearchThread *t : threads)
+    {
+        t->pos = root;
+        t->keys = history;
+        t->nodes = 0;
+        t->qnodes = 0;
+        t->nullMinPly = 0;
+        t->failHighs = 0;
+        t->failHighsFirst = 0;
+        t->movesGenerated = 0;
+        t->ttStats = TTStats();
+        t->pawnTable.resetStats();
+        memset(t->killers, 0, sizeof(t->killers));
+        memset(t->counterMoves, 0, sizeof(t->counterMoves));
+        memset(t->history, 0, sizeof(t->history));
+        if (useNetwork)
+            t->accumulators.reset(*network, root);
+    }
+
+    SearchThread &main = *threads[0];
+    SearchInfo info = {};
+    MoveList rootMoves;
+    generateLegalMoves(root, rootMoves);
+    if (rootMoves.size() > 0)
+        info.bestMove = rootMoves[0];
+
+    int maxDepth = limits.depth > 0 ? min(limits.depth, maxply - 1) : maxply - 1;
+    vector<thread> helpers;
+    for (size_t i = 1; i < threads.size() && rootMoves.size() > 1; i++)
+        helpers.emplace_back(&Search::helperSearch, this, ref(*threads[i]), maxDepth);
+
+    for (int depth = 1; depth <= maxDepth && rootMoves.size() > 0; depth++)
+    {
+        main.iterationBest = nomove;
+        unsigned long long nodesBefore = main.nodes;
+        int score = pvs(main, -infinitescore, infinitescore, depth, 0);
+        if (stopped)
+        {
+            // A root move that already beat the previous best in the
+            // unfinished iteration was searched fully and is kept.
+            if (main.iterationBest != nomove)
+                info.bestMove = main.iterationBest;
+            break;
+        }
+
+        info.depth = depth;
+        info.score = score;
+        info.iterationNodes[depth] = main.nodes - nodesBefore;
+        info.bestMove = main.pvTable[0][0];
+        info.pvLength = main.pvLength[0];
+        copy(main.pvTable[0], main.pvTable[0] + main.pvLength[0], info.pv);
+
+        // A forced move or a found mate won't change with more depth.
+        if (rootMoves.size() == 1 || abs(score) >= matebound)
+            break;
+        if (limits.softTime > 0 && elapsed() * 1000 >= limits.softTime / 2)
+            break;
+    }
+
+    stopped = true;
+    for (thread &helper : helpers)
+        helper.join();
+
+    for (SearchThread *t : threads)
+    {
+        info.nodes += t->nodes;
+        info.qnodes += t->qnodes;
+        info.failHighs += t->failHighs;
+        info.failHighsFirst += t->failHighsFirst;
+        info.movesGenerated += t->movesGenerated;
+        info.ttStats.probes += t->ttStats.probes;
+        info.ttStats.hits += t->ttStats.hits;
+        info.ttStats.stores += t->ttStats.stores;
+        info.ttStats.collisions += t->ttStats.collisions;
+        info.pawnStats.probes += t->pawnTable.stats().probes;
+        info.pawnStats.hits += t->pawnTable.stats().hits;
+    }
+    info.seconds = elapsed();
+    info.hashfull = tt.hashfull();
+    return info;
+}
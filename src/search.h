@@ -0,0 +1,175 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include "nnue.h"
+#include "pawns.h"
+#include "position.h"
+#include "tt.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+const int maxply = 128;
+const int infinitescore = 32001;
+const int matescore = 32000;
+const int matebound = matescore - maxply;
+
+// Times are in milliseconds, 0 for no limit. After an iteration the search
+// stops if it is past half of softTime, since the next iteration would
+// likely overrun; hardTime is polled every few thousand nodes and ends the
+// search mid-iteration.
+struct SearchLimits
+{
+    int depth;
+    int softTime;
+    int hardTime;
+};
+
+// Search features that can be switched off at runtime, so what each is worth
+// can be measured. Change them only between searches.
+struct SearchOptions
+{
+    // Skip quiescence captures that lose material by static exchange.
+    bool seePruning = true;
+    // Give the opponent a free move; if a reduced search still fails high
+    // the node is cut without searching a real move.
+    bool nullMove = true;
+    // Search late quiet moves with less depth, less still for those with
+    // poor history, and re-search any that beat alpha.
+    bool lateMoveReductions = true;
+    // Near the leaves, cut nodes whose static evaluation is far above beta
+    // and skip quiet moves that can't bring it up to alpha.
+    bool futilityPruning = true;
+    // Evaluate with the network when one is set, instead of the piece-square
+    // tables.
+    bool nnue = true;
+};
+
+// Result of the deepest completed iteration.
+struct SearchInfo
+{
+    Move bestMove;
+    int score;
+    int depth;
+    unsigned long long nodes;
+    unsigned long long qnodes;
+    double seconds;
+    Move pv[maxply];
+    int pvLength;
+    TTStats ttStats;
+    int hashfull;
+    PawnHashStats pawnStats;
+    unsigned long long failHighs;
+    unsigned long long failHighsFirst;
+    unsigned long long movesGenerated;
+    // Nodes the main thread spent on each iteration, indexed by depth.
+    unsigned long long iterationNodes[maxply];
+
+    double nps() const { return seconds > 0 ? nodes / seconds : 0; }
+    // Share of beta cutoffs made by the first move searched: the usual
+    // measure of how well moves are ordered.
+    double failHighFirstRate() const { return failHighs ? (double)failHighsFirst / failHighs : 0; }
+    // Moves the generator produced per node searched, which staged
+    // generation keeps down by stopping at the first cutoff.
+    double movesPerNode() const { return nodes ? (double)movesGenerated / nodes : 0; }
+    // Effective branching factor: growth in nodes per iteration, averaged
+    // over the last two to smooth out the odd-even effect.
+    double branchingFactor() const
+    {
+        if (depth < 3 || iterationNodes[depth - 2] == 0)
+            return 0;
+        return std::sqrt((double)iterationNodes[depth] / iterationNodes[depth - 2]);
+    }
+};
+
+// Everything one search thread writes. Each is allocated separately and
+// cache-line aligned, so threads updating their own killer and history
+// tables never write to a line another thread is using.
+struct alignas(64) SearchThread
+{
+    int id;
+    Position pos;
+    std::vector<Bitboard> keys;
+    unsigned long long nodes;
+    unsigned long long qnodes;
+    unsigned long long failHighs;
+    unsigned long long failHighsFirst;
+    unsigned long long movesGenerated;
+    TTStats ttStats;
+    Move iterationBest;
+    Move pvTable[maxply][maxply];
+    int pvLength[maxply];
+    Move moveStack[maxply];
+    // Null moves are off below this ply while a null-move cutoff is
+    // verified.
+    int nullMinPly;
+    Move killers[maxply][2];
+    Move counterMoves[2 * piecetypes][64];
+    int history[2][64][64];
+    PawnHashTable pawnTable;
+    // Follows pos move by move while the network evaluates.
+    AccumulatorStack accumulators;
+};
+
+// Iterative-deepening principal variation search. think() runs on a copy of
+// the position and may be called from a worker thread after prepare();
+// stop() can be called from any thread, even before think() starts, and
+// makes think() return the last completed iteration.
+//
+// With more than one thread the search is Lazy SMP: helpers search the same
+// root, odd ones a ply deeper, and help only through the shared
+// transposition table. The main thread alone watches the clock and
+// decides when to stop; its result is the one returned.
+class Search
+{
+    TranspositionTable &tt;
+    std::vector<SearchThread *> threads;
+    std::atomic<bool> stopped;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point hardDeadline;
+    bool useHardDeadline;
+    SearchOptions options;
+    const Network *network;
+    // Whether this search evaluates with the network.
+    bool useNetwork;
+
+    // Make and unmake keep the repetition keys and the accumulators in step
+    // with the position.
+    void makeMove(SearchThread &t, Move m, UndoInfo &undo, AttackState &attacks);
+    void unmakeMove(SearchThread &t, Move m, const UndoInfo &undo, const AttackState &attacks);
+    void makeNullMove(SearchThread &t, UndoInfo &undo);
+    void unmakeNullMove(SearchThread &t, const UndoInfo &undo);
+    int evaluateNode(SearchThread &t);
+    int pvs(SearchThread &t, int alpha, int beta, int depth, int ply);
+    int quiesce(SearchThread &t, int alpha, int beta, int ply);
+    bool isDraw(const SearchThread &t) const;
+    void checkTime();
+    double elapsed() const;
+    void helperSearch(SearchThread &t, int maxDepth);
+
+public:
+    explicit Search(TranspositionTable &table, int threadCount = 1);
+    ~Search();
+    Search(const Search &) = delete;
+    Search &operator=(const Search &) = delete;
+
+    void setThreads(int count);
+    int threadCount() const { return (int)threads.size(); }
+    void setOptions(const SearchOptions &o) { options = o; }
+    const SearchOptions &getOptions() const { return options; }
+    // The network must outlive the searches using it; nullptr goes back to
+    // the piece-square tables.
+    void setNetwork(const Network *net) { network = net; }
+
+    // Clears the stop flag; call it before every think(), on the thread
+    // that may later call stop(), so a stop issued before the worker
+    // reaches think() is not lost.
+    void prepare() { stopped = false; }
+    // history holds the keys of the positions played before root, oldest
+    // first, for repetition detection.
+    SearchInfo think(const Position &root, const std::vector<Bitboard> &history, const SearchLimits &limits);
+    void stop() { stopped = true; }
+};
+
+#endif
@@ -0,0 +1,104 @@
+#include "see.h"
+#include "bitboard.h"
+#include "eval.h"
+#include <algorithm>
+using namespace std;
+
+// Attackers are tried cheapest first.
+inline constexpr int exchangeOrder[piecetypes] = {piecepawn, pieceknight, piecebishop, piecerook, piecequeen, pieceking};
+
+// Captures on one square can't outnumber the pieces on the board.
+const int maxexchange = 33;
+
+int see(const Position &pos, Move m)
+{
+    int from = moveFrom(m);
+    int to = moveTo(m);
+    int side = colorOf(pos.pieceAt(from));
+    int moving = typeOf(pos.pieceAt(from));
+    Bitboard occupied = pos.occupied() ^ squareBit(from);
+
+    int gain[maxexchange];
+    gain[0] = 0;
+    if (moveFlags(m) == flagenpassant)
+    {
+        gain[0] = pieceValues[piecepawn];
+        occupied ^= squareBit(to + (side == colorwhite ? 8 : -8));
+    }
+    else if (isCapture(m))
+    {
+        gain[0] = pieceValues[typeOf(pos.pieceAt(to))];
+    }
+    if (isPromotion(m))
+    {
+        moving = promotionType(m);
+        gain[0] += pieceValues[moving] - pieceValues[piecepawn];
+    }
+
+    // gain[d] is what the side making capture d has won if the exchange
+    // stops there; the attacker set is rebuilt after every capture so
+    // sliders behind the pieces that left are found.
+    int depth = 0;
+    side = opponent(side);
+    Bitboard attackers = pos.attackersTo(to, occupied) & occupied;
+    while (Bitboard ours = attackers & pos.pieces(side))
+    {
+        int type = pieceking;
+        Bitboard candidates = 0;
+        for (int t : exchangeOrder)
+        {
+            candidates = ours & pos.pieces(side, t);
+            if (candidates)
+            {
+                type = t;
+                break;
+            }
+        }
+        Bitboard next = occupied ^ squareBit(lsb(candidates));
+        Bitboard nextAttackers = pos.attackersTo(to, next) & next;
+        // The king may only take last.
+        if (type == pieceking && (nextAttackers & pos.pieces(opponent(side))))
+            break;
+
+        depth++;
+        gain[depth] = pieceValues[moving] - gain[depth - 1];
+        occupied = next;
+        attackers = nextAttackers;
+        moving = type;
+        side = opponent(side);
+    }
+
+    while (depth > 0)
+    {
+        gain[depth - 1] = -max(-gain[depth - 1], gain[depth]);
+        depth--;
+    }
+    return gain[0];
+}
+
+Bitboard hangingPieces(const Position &pos, int color)
+{
+    int them = opponent(color);
+    Bitboard hanging = 0;
+    Bitboard targets = pos.pieces(color) & ~pos.pieces(color, pieceking) & pos.attackedBy(them);
+    while (targets)
+    {
+        int sq = popLsb(targets);
+        Bitboard attackers = pos.attackersTo(sq, pos.occupied()) & pos.pieces(them);
+        bool lastRow = squareY(sq) == (them == colorwhite ? 0 : 7);
+        while (attackers)
+        {
+            int from = popLsb(attackers);
+            if (from == pos.kingSquare(them) && pos.isSquareAttacked(sq, color))
+                continue;
+            bool promotes = lastRow && (pos.pieces(them, piecepawn) & squareBit(from));
+            int flags = promotes ? promotionFlags(piecequeen, true) : flagcapture;
+            if (see(pos, makeMove(from, sq, flags)) > 0)
+            {
+                hanging |= squareBit(sq);
+                break;
+            }
+        }
+    }
+    return hanging;
+}
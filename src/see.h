@@ -0,0 +1,16 @@
+#ifndef SEE_H
+#define SEE_H
+
+#include "position.h"
+
+// Static exchange evaluation: the material the mover of m wins by making the
+// capture and then trading on its square, each side always recapturing with
+// its least valuable piece and free to stop when recapturing would lose.
+// Pins are ignored; x-ray attackers behind the traded pieces are not.
+int see(const Position &pos, Move m);
+
+// Pieces of color, other than the king, that the opponent can capture with
+// a positive exchange.
+Bitboard hangingPieces(const Position &pos, int color);
+
+#endif
@@ -0,0 +1,23 @@
+#include "timeman.h"
+#include <algorithm>
+using namespace std;
+
+const int timemargin = 50;
+const int expectedgamelength = 60;
+const int minmovestogo = 20;
+const int hardtimefactor = 4;
+const int hardtimeshare = 4;
+
+TimeAllocation allocateTime(int timeLeft, int moveNumber)
+{
+    // Keep a margin for the GUI frame that plays the move, and spread the
+    // rest over the moves a game of typical length still needs, never fewer
+    // than minmovestogo so late moves are not overspent.
+    int available = max(timeLeft - timemargin, 1);
+    int movesToGo = max(minmovestogo, expectedgamelength - moveNumber);
+
+    TimeAllocation allocation;
+    allocation.soft = max(available / movesToGo, 1);
+    allocation.hard = max(min(allocation.soft * hardtimefactor, available / hardtimeshare), allocation.soft);
+    return allocation;
+}
@@ -0,0 +1,14 @@
+#ifndef TIMEMAN_H
+#define TIMEMAN_H
+
+// Budget for one move, in milliseconds. The search stops deepening once the
+// soft limit is near and abandons the current iteration at the hard limit.
+struct TimeAllocation
+{
+    int soft;
+    int hard;
+};
+
+TimeAllocation allocateTime(int timeLeft, int moveNumber);
+
+#endif
@@ -0,0 +1,165 @@
+#include "tt.h"
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
+using namespace std;
+
+const size_t hugepagesize = 2 * 1024 * 1024;
+
+// data layout: move in bits 0-15, score in 16-31, depth in 32-39, bound in
+// 40-41 and generation in 42-47. An empty entry is all zero.
+static Bitboard packEntry(Move move, int score, int depth, int bound, int generation)
+{
+    return (Bitboard)move | (Bitboard)(unsigned short)score << 16 | (Bitboard)depth << 32 |
+           (Bitboard)bound << 40 | (Bitboard)generation << 42;
+}
+
+static Move entryMove(Bitboard data) { return (Move)data; }
+static int entryScore(Bitboard data) { return (short)(data >> 16); }
+static int entryDepth(Bitboard data) { return (int)(data >> 32) & 255; }
+static int entryBound(Bitboard data) { return (int)(data >> 40) & 3; }
+static int entryGeneration(Bitboard data) { return (int)(data >> 42) & 63; }
+
+// Aligned to a huge page on Linux and advised to use transparent huge pages,
+// which saves most of the TLB misses of random probes into a large table.
+static void *allocateTable(size_t bytes)
+{
+#ifdef _WIN32
+    return _aligned_malloc(bytes, alignof(TTBucket));
+#else
+    void *memory = nullptr;
+    size_t alignment = bytes >= hugepagesize ? hugepagesize : alignof(TTBucket);
+    if (posix_memalign(&memory, alignment, bytes) != 0)
+        return nullptr;
+#ifdef __linux__
+    if (alignment == hugepagesize)
+        madvise(memory, bytes, MADV_HUGEPAGE);
+#endif
+    return memory;
+#endif
+}
+
+static void freeTable(void *memory)
+{
+#ifdef _WIN32
+    _aligned_free(memory);
+#else
+    free(memory);
+#endif
+}
+
+TranspositionTable::TranspositionTable(size_t megabytes) : buckets(nullptr), bucketCount(0), generation(0)
+{
+    resize(megabytes);
+}
+
+TranspositionTable::~TranspositionTable()
+{
+    freeTable(buckets);
+}
+
+void TranspositionTable::resize(size_t megabytes)
+{
+    size_t count = 1;
+    while (count * 2 * sizeof(TTBucket) <= megabytes << 20)
+        count *= 2;
+
+    freeTable(buckets);
+    buckets = (TTBucket *)allocateTable(count * sizeof(TTBucket));
+    if (!buckets)
+        throw bad_alloc();
+    bucketCount = count;
+    for (size_t i = 0; i < bucketCount; i++)
+        new (&buckets[i]) TTBucket();
+    clear();
+}
+
+void TranspositionTable::clear()
+{
+    for (size_t i = 0; i < bucketCount; i++)
+    {
+        for (TTEntry &e : buckets[i].entries)
+        {
+            e.check.store(0, memory_order_relaxed);
+            e.data.store(0, memory_order_relaxed);
+        }
+    }
+    generation = 0;
+}
+
+bool TranspositionTable::probe(Bitboard key, TTHit &hit) const
+{
+    TTBucket &bucket = bucketFor(key);
+    for (TTEntry &e : bucket.entries)
+    {
+        Bitboard data = e.data.load(memory_order_relaxed);
+        if ((e.check.load(memory_order_relaxed) ^ data) == key && entryBound(data) != boundnone)
+        {
+            hit.move = entryMove(data);
+            hit.score = entryScore(data);
+            hit.depth = entryDepth(data);
+            hit.bound = entryBound(data);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TranspositionTable::store(Bitboard key, Move move, int score, int depth, int bound)
+{
+    // Reuse this position's entry if it has one, else replace the entry with
+    // the least depth, counting entries from earlier searches as shallower.
+    TTBucket &bucket = bucketFor(key);
+    TTEntry *victim = nullptr;
+    Bitboard victimData = 0;
+    int victimWorth = 1 << 30;
+    bool samePosition = false;
+    for (TTEntry &e : bucket.entries)
+    {
+        Bitboard data = e.data.load(memory_order_relaxed);
+        if ((e.check.load(memory_order_relaxed) ^ data) == key)
+        {
+            victim = &e;
+            victimData = data;
+            samePosition = true;
+            break;
+        }
+        int age = (generation - entryGeneration(data)) & 63;
+        int worth = entryBound(data) == boundnone ? -1000 : entryDepth(data) - 8 * age;
+        if (worth < victimWorth)
+        {
+            victim = &e;
+            victimData = data;
+            victimWorth = worth;
+        }
+    }
+
+    if (move == nomove && samePosition)
+        move = entryMove(victimData);
+    Bitboard data = packEntry(move, score, depth > 255 ? 255 : depth, bound, generation);
+    victim->check.store(key ^ data, memory_order_relaxed);
+    victim->data.store(data, memory_order_relaxed);
+    return !samePosition && entryBound(victimData) != boundnone;
+}
+
+int TranspositionTable::hashfull() const
+{
+    int sampled = 0;
+    int used = 0;
+    for (size_t i = 0; i < bucketCount && sampled < 1000; i++)
+    {
+        for (TTEntry &e : buckets[i].entries)
+        {
+            Bitboard data = e.data.load(memory_order_relaxed);
+            sampled++;
+            if (entryBound(data) != boundnone && entryGeneration(data) == generation)
+                used++;
+        }
+    }
+    return sampled ? used * 1000 / sampled : 0;
+}
@@ -0,0 +1,78 @@
+#ifndef TT_H
+#define TT_H
+
+#include "types.h"
+#include <atomic>
+#include <cstddef>
+
+const int boundnone = 0;
+const int boundupper = 1;
+const int boundlower = 2;
+const int boundexact = 3;
+
+const int ttbucketsize = 4;
+
+// An entry is two words: the data, and the key XORed with the data. Threads
+// read and write without locks; an entry torn by a concurrent store no
+// longer verifies against the key and reads as a miss.
+struct TTEntry
+{
+    std::atomic<Bitboard> check;
+    std::atomic<Bitboard> data;
+};
+
+// One bucket fills one cache line, so a probe costs at most one miss.
+struct alignas(64) TTBucket
+{
+    TTEntry entries[ttbucketsize];
+};
+
+struct TTHit
+{
+    Move move;
+    int score;
+    int depth;
+    int bound;
+};
+
+// Counted by each search thread, so the shared table holds no counters.
+struct TTStats
+{
+    unsigned long long probes;
+    unsigned long long hits;
+    unsigned long long stores;
+    unsigned long long collisions;
+
+    double hitRate() const { return probes ? (double)hits / probes : 0; }
+};
+
+class TranspositionTable
+{
+    TTBucket *buckets;
+    size_t bucketCount;
+    unsigned char generation;
+
+    TTBucket &bucketFor(Bitboard key) const { return buckets[key & (bucketCount - 1)]; }
+
+public:
+    explicit TranspositionTable(size_t megabytes);
+    ~TranspositionTable();
+    TranspositionTable(const TranspositionTable &) = delete;
+    TranspositionTable &operator=(const TranspositionTable &) = delete;
+
+    // Reallocates to the largest power-of-two bucket count that fits.
+    void resize(size_t megabytes);
+    void clear();
+    // Ages existing entries so they are replaced first.
+    void newSearch() { generation = (generation + 1) & 63; }
+
+    bool probe(Bitboard key, TTHit &hit) const;
+    // Returns true when the store evicted an entry for another position.
+    bool store(Bitboard key, Move move, int score, int depth, int bound);
+
+    void prefetch(Bitboard key) const { __builtin_prefetch(&bucketFor(key)); }
+    // Entries written in the current search, per thousand, from a sample.
+    int hashfull() const;
+};
+
+#endif
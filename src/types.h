@@ -0,0 +1,79 @@
+#ifndef TYPES_H
+#define TYPES_H
+
+typedef unsigned long long Bitboard;
+
+const int colorwhite = 0;
+const int colorblack = 1;
+
+const int piecepawn = 0;
+const int piecerook = 1;
+const int pieceknight = 2;
+const int piecebishop = 3;
+const int piecequeen = 4;
+const int pieceking = 5;
+const int piecetypes = 6;
+
+const int nopiece = -1;
+const int nosquare = -1;
+
+const int castlewhiteking = 1;
+const int castlewhitequeen = 2;
+const int castleblackking = 4;
+const int castleblackqueen = 8;
+
+// Squares are numbered in screen order: x is the file (0 = a), y is the row from
+// the top of the board (0 = black's back rank), matching pieceBoard[x][y].
+constexpr int makeSquare(int x, int y) { return y * 8 + x; }
+constexpr int squareX(int sq) { return sq & 7; }
+constexpr int squareY(int sq) { return sq >> 3; }
+constexpr Bitboard squareBit(int sq) { return 1ULL << sq; }
+
+constexpr int makePiece(int color, int type) { return color * piecetypes + type; }
+constexpr int colorOf(int piece) { return piece / piecetypes; }
+constexpr int typeOf(int piece) { return piece % piecetypes; }
+constexpr int opponent(int color) { return color ^ 1; }
+
+// A move packs from (bits 0-5), to (bits 6-11) and four flag bits. Flag bit 2
+// marks captures and bit 3 promotions, whose piece is in the low two bits.
+typedef unsigned short Move;
+
+const Move nomove = 0;
+
+const int flagquiet = 0;
+const int flagdoublepush = 1;
+const int flagkingcastle = 2;
+const int flagqueencastle = 3;
+const int flagcapture = 4;
+const int flagenpassant = 5;
+const int flagpromotion = 8;
+const int flagpromocapture = 12;
+
+constexpr Move makeMove(int from, int to, int flags) { return (Move)(from | (to << 6) | (flags << 12)); }
+constexpr int moveFrom(Move m) { return m & 63; }
+constexpr int moveTo(Move m) { return (m >> 6) & 63; }
+constexpr int moveFlags(Move m) { return m >> 12; }
+constexpr bool isCapture(Move m) { return (m >> 12) & flagcapture; }
+constexpr bool isPromotion(Move m) { return (m >> 12) & flagpromotion; }
+constexpr bool isCastling(Move m) { return moveFlags(m) == flagkingcastle || moveFlags(m) == flagqueencastle; }
+inline constexpr int promotionPieces[4] = {pieceknight, piecebishop, piecerook, piecequeen};
+
+constexpr int promotionType(Move m) { return promotionPieces[(m >> 12) & 3]; }
+constexpr int promotionFlags(int type, bool capture)
+{
+    int index = 0;
+    while (promotionPieces[index] != type)
+        index++;
+    return (capture ? flagpromocapture : flagpromotion) | index;
+}
+
+inline int popCount(Bitboard b) { return __builtin_popcountll(b); }
+inline int lsb(Bitboard b) { return __builtin_ctzll(b); }
+inline int popLsb(Bitboard &b)
+{
+    int sq = lsb(b);
+    b &= b - 1;
+    return sq;
+}
+
+#endif
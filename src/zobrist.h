@@ -0,0 +1,41 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include "types.h"
+
+struct ZobristKeys
+{
+    Bitboard pieces[2][piecetypes][64];
+    Bitboard castling[16];
+    Bitboard enPassantFile[8];
+    Bitboard side;
+};
+
+constexpr Bitboard splitMix64(Bitboard &state)
+{
+    state += 0x9E3779B97F4A7C15ULL;
+    Bitboard z = state;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+constexpr ZobristKeys makeZobristKeys()
+{
+    ZobristKeys keys{};
+    Bitboard state = 0x43686573734B6579ULL;
+    for (int c = 0; c < 2; c++)
+        for (int t = 0; t < piecetypes; t++)
+            for (int sq = 0; sq < 64; sq++)
+                keys.pieces[c][t][sq] = splitMix64(state);
+    for (int i = 0; i < 16; i++)
+        keys.castling[i] = i ? splitMix64(state) : 0;
+    for (int f = 0; f < 8; f++)
+        keys.enPassantFile[f] = splitMix64(state);
+    keys.side = splitMix64(state);
+    return keys;
+}
+
+inline constexpr ZobristKeys zobrist = makeZobristKeys();
+
+#endif